@@ -0,0 +1,307 @@
+#include "Anim.h"
+#include "IffReader.h"
+#include "Planar.h"
+#include "Trace.h"
+#include "ViewModes.h"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace {
+/* ANHD operations */
+constexpr std::uint8_t OperationByteVertical = 5;
+constexpr std::uint8_t OperationVertical = 7;
+/* ANHD bits of operation 7: the data are longs instead of shorts */
+constexpr std::uint32_t BitsLongData = 1;
+/* bytes of ANHD up to its bits, the padding after them is ignored */
+constexpr std::size_t HeaderSize = 24;
+/* planes of the frames, the deep images have no delta */
+constexpr int MaxPlanes = 8;
+
+using Bounds = Anim::Bounds;
+
+[[noreturn]] void fail(const char *chunk, const std::string &what) {
+  std::ostringstream ss;
+  ss << "Error when reading the " << chunk << " chunk: " << what;
+  throw std::runtime_error(ss.str());
+}
+
+/* reads a list of a DLTA chunk from offset, checking its end */
+class DeltaReader {
+public:
+  DeltaReader(Span<const std::uint8_t> delta, std::size_t offset) : m_delta(delta), m_offset(offset) {}
+
+  std::uint8_t next() { return *take(1); }
+
+  const std::uint8_t *take(std::size_t size) {
+    if (m_offset > m_delta.size() || m_delta.size() - m_offset < size)
+      fail("DLTA", "a list runs past its end");
+    const auto *data = m_delta.data() + m_offset;
+    m_offset += size;
+    return data;
+  }
+
+private:
+  Span<const std::uint8_t> m_delta;
+  std::size_t m_offset;
+};
+
+/* Applies the ops of one plane, columns of itemSize bytes from the left: the number of ops of the column then
+ * its ops, a skip of 1 to 127 rows, a run of one item (0 then the number of rows) or a number of items copied
+ * one per row (bit 7 set). The items are read from data, which is ops itself for operation 5. */
+void applyColumns(DeltaReader &ops, DeltaReader &data, std::size_t itemSize, std::size_t lineSize, std::size_t height,
+                  std::uint8_t *plane, Bounds &changed) {
+  // a last column narrower than the items is left as it is
+  const auto numColumns = lineSize / itemSize;
+  for (std::size_t column = 0; column < numColumns; column++) {
+    auto *out = plane + column * itemSize;
+    std::size_t row = 0, first = height, last = 0;
+    for (auto numOps = ops.next(); numOps > 0; numOps--) {
+      const auto op = ops.next();
+      if (op > 0 && op < 0x80) {
+        row += op;
+        continue;
+      }
+      const std::size_t count = op == 0 ? ops.next() : op & 0x7f;
+      if (row + count > height)
+        fail("DLTA", "a column runs past the bottom of the image");
+      const auto *item = op == 0 ? data.take(itemSize) : nullptr;
+      for (std::size_t k = 0; k < count; k++) {
+        std::memcpy(out + (row + k) * lineSize, op == 0 ? item : data.take(itemSize), itemSize);
+      }
+      first = std::min(first, row);
+      row += count;
+      last = row;
+    }
+    if (first < last)
+      changed.add({first, last, column * itemSize, (column + 1) * itemSize});
+  }
+}
+
+/* the bounds of the bytes of a and b which differ within candidate */
+Bounds diff(const std::uint8_t *a, const std::uint8_t *b, const Bounds &candidate, int numPlanes, std::size_t lineSize,
+            std::size_t planeSize) {
+  Bounds result;
+  if (candidate.isEmpty())
+    return result;
+  const auto size = candidate.right - candidate.left;
+  for (auto y = candidate.top; y < candidate.bottom; y++) {
+    for (auto p = 0; p < numPlanes; p++) {
+      const auto offset = p * planeSize + y * lineSize + candidate.left;
+      if (std::memcmp(a + offset, b + offset, size) == 0)
+        continue;
+      auto left = std::size_t{0}, right = size;
+      while (a[offset + left] == b[offset + left])
+        left++;
+      while (a[offset + right - 1] == b[offset + right - 1])
+        right--;
+      result.add({y, y + 1, candidate.left + left, candidate.left + right});
+    }
+  }
+  return result;
+}
+}// namespace
+
+void Anim::Bounds::add(const Bounds &other) {
+  if (other.isEmpty())
+    return;
+  if (isEmpty()) {
+    *this = other;
+    return;
+  }
+  top = std::min(top, other.top);
+  bottom = std::max(bottom, other.bottom);
+  left = std::min(left, other.left);
+  right = std::max(right, other.right);
+}
+
+Anim::Rect Anim::Rect::united(const Rect &other) const {
+  if (other.isEmpty())
+    return *this;
+  if (isEmpty())
+    return other;
+  const auto left = std::min(x, other.x), top = std::min(y, other.y);
+  const auto right = std::max(x + width, other.x + other.width), bottom = std::max(y + height, other.y + other.height);
+  return {left, top, right - left, bottom - top};
+}
+
+bool Anim::isAnim(Span<const std::uint8_t> data) {
+  return data.size() >= 12 && std::memcmp(data.data(), "FORM", 4) == 0 && std::memcmp(data.data() + 8, "ANIM", 4) == 0;
+}
+
+Anim::Anim(std::shared_ptr<const MappedFile> file, Ilbm &image) : m_file(std::move(file)) {
+  TRACE_SCOPE("Anim");
+  const auto &header = image.header;
+  if ((image.isTrueColor() && !image.isHam()) || header.num_planes == 0 || header.num_planes > MaxPlanes) {
+    std::ostringstream ss;
+    ss << "Error when reading the ANIM: " << static_cast<int>(header.num_planes) << " bitplanes are not supported";
+    throw std::runtime_error(ss.str());
+  }
+  const auto stride = image.stride();
+  if (image.pixels().size() < stride * header.height)
+    throw std::runtime_error("Error when reading the ANIM: its first frame has no body");
+
+  IffReader reader(m_file->getData());
+  if (reader.getFormType() != "ANIM")
+    throw std::runtime_error("Error when reading the ANIM: not a FORM ANIM");
+  // the first FORM is the image, the next ones the deltas
+  IffChunk chunk;
+  auto isFirst = true;
+  while (reader.next(chunk)) {
+    if (!chunk.is("FORM"))
+      continue;
+    if (std::exchange(isFirst, false))
+      continue;
+    // the chunk is the inside of a FORM, its header is just before it
+    IffReader form(Span<const std::uint8_t>(chunk.data.data() - 8, chunk.data.size() + 8));
+    Frame frame;
+    auto hasHeader = false;
+    IffChunk part;
+    while (form.next(part)) {
+      if (part.is("ANHD")) {
+        if (part.data.size() < HeaderSize)
+          fail("ANHD", "too short");
+        hasHeader = true;
+        frame.operation = part.data[0];
+        frame.delay = static_cast<int>(std::clamp<std::uint32_t>(readU32(part.data, 14), 1, 60 * 60));
+        frame.interleave = part.data[18];
+        frame.bits = readU32(part.data, 20);
+      } else if (part.is("DLTA")) {
+        frame.delta = part.data;
+      }
+    }
+    if (!hasHeader)
+      fail("ANHD", "missing in a frame");
+    if (frame.operation != OperationByteVertical && frame.operation != OperationVertical) {
+      std::ostringstream ss;
+      ss << "operation " << static_cast<int>(frame.operation) << " is not supported";
+      fail("ANHD", ss.str());
+    }
+    m_frames.push_back(frame);
+  }
+
+  m_numPlanes = header.num_planes;
+  m_lineSize = Planar::getLineSize(header.width);
+  m_planeSize = m_lineSize * header.height;
+  m_first.assign(m_planeSize * m_numPlanes, 0);
+  const auto pixels = image.pixels();
+  std::uint8_t *planes[MaxPlanes];
+  for (std::size_t y = 0; y < header.height; y++) {
+    for (auto p = 0; p < m_numPlanes; p++) {
+      planes[p] = m_first.data() + p * m_planeSize + y * m_lineSize;
+    }
+    Planar::toPlanar(pixels.data() + y * stride, header.width, m_numPlanes, planes);
+  }
+  m_buffers = {m_first, m_first};
+
+  // the frames are written into a copy of the indices, the mapped ones stay alive for the rows still uploaded
+  // from them
+  if (!image.mappedImage.empty()) {
+    image.image.assign(image.mappedImage.begin(), image.mappedImage.end());
+    image.mappedImage = {};
+  }
+}
+
+int Anim::getDelay() const {
+  return m_frames.empty() ? 1 : m_frames[m_frame % m_frames.size()].delay;
+}
+
+Anim::Rect Anim::next(Ilbm &image) {
+  TRACE_SCOPE("Anim::next");
+  if (m_frames.empty())
+    return {};
+  const auto height = static_cast<std::size_t>(image.header.height);
+  Bounds changed;
+  if (m_frame == m_frames.size()) {
+    // back to the first frame, from the last one
+    changed = diff(m_buffers[m_frame & 1].data(), m_first.data(), {0, height, 0, m_lineSize}, m_numPlanes, m_lineSize, m_planeSize);
+    m_buffers = {m_first, m_first};
+    m_frame = 0;
+    m_changed = {};
+  } else {
+    const auto &frame = m_frames[m_frame];
+    const auto &shown = m_buffers[m_frame & 1];
+    auto &target = m_buffers[(m_frame + 1) & 1];
+    // the target holds the frame before the shown one, which is the reference of the deltas but for interleave 1
+    const auto previous = m_changed;
+    if (frame.interleave == 1 && !previous.isEmpty()) {
+      for (auto p = 0; p < m_numPlanes; p++) {
+        for (auto y = previous.top; y < previous.bottom; y++) {
+          const auto offset = p * m_planeSize + y * m_lineSize + previous.left;
+          std::memcpy(target.data() + offset, shown.data() + offset, previous.right - previous.left);
+        }
+      }
+    }
+    Bounds applied;
+    const auto delta = frame.delta;
+    if (frame.operation == OperationByteVertical) {
+      // one list per plane, up to 16 of them
+      if (delta.size() < 16 * 4)
+        fail("DLTA", "too short");
+      for (auto p = 0; p < m_numPlanes; p++) {
+        const auto offset = readU32(delta, p * 4);
+        if (offset == 0)
+          continue;
+        DeltaReader ops(delta, offset);
+        applyColumns(ops, ops, 1, m_lineSize, height, target.data() + p * m_planeSize, applied);
+      }
+    } else {
+      // the lists of opcodes of the 8 planes then their lists of data
+      if (delta.size() < 16 * 4)
+        fail("DLTA", "too short");
+      const std::size_t itemSize = frame.bits & BitsLongData ? 4 : 2;
+      for (auto p = 0; p < m_numPlanes; p++) {
+        const auto opsOffset = readU32(delta, p * 4);
+        if (opsOffset == 0)
+          continue;
+        DeltaReader ops(delta, opsOffset);
+        DeltaReader data(delta, readU32(delta, 32 + p * 4));
+        applyColumns(ops, data, itemSize, m_lineSize, height, target.data() + p * m_planeSize, applied);
+      }
+    }
+    // the frame shown next differs from the shown one where the buffers differed before or where the delta wrote
+    applied.add(previous);
+    changed = diff(target.data(), shown.data(), applied, m_numPlanes, m_lineSize, m_planeSize);
+    m_changed = changed;
+    m_frame++;
+  }
+  if (changed.isEmpty())
+    return {};
+
+  const int width = image.header.width;
+  Rect rect;
+  rect.x = static_cast<int>(changed.left * 8);
+  rect.y = static_cast<int>(changed.top);
+  rect.width = std::min(static_cast<int>(changed.right * 8), width) - rect.x;
+  rect.height = static_cast<int>(changed.bottom - changed.top);
+  // the colors of a HAM line depend on all the pixels on their left
+  if (image.isHam()) {
+    rect.x = 0;
+    rect.width = width;
+  }
+  if (rect.isEmpty())
+    return {};
+  convert(rect, image);
+  return rect;
+}
+
+void Anim::convert(const Rect &rect, Ilbm &image) const {
+  const auto &planar = m_buffers[m_frame & 1];
+  const auto stride = image.stride();
+  std::optional<ViewModes::HamResolver> ham;
+  if (image.isHam())
+    ham.emplace(m_numPlanes, image.palette.data());
+  const std::uint8_t *planes[MaxPlanes];
+  for (auto y = rect.y; y < rect.y + rect.height; y++) {
+    for (auto p = 0; p < m_numPlanes; p++) {
+      planes[p] = planar.data() + p * m_planeSize + y * m_lineSize + rect.x / 8;
+    }
+    auto *indices = image.image.data() + y * stride;
+    Planar::toChunky(planes, m_numPlanes, static_cast<std::size_t>(rect.width), indices + rect.x);
+    if (ham)
+      ham->resolveRow(indices, image.header.width, image.rgb.data() + y * stride * 3);
+  }
+}
@@ -0,0 +1,84 @@
+#ifndef COLORCYCLING__ANIM_H
+#define COLORCYCLING__ANIM_H
+
+#include "Ilbm.h"
+#include "MappedFile.h"
+#include "Span.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* Plays an IFF ANIM: a FORM ANIM of ILBM forms, the first one a whole image and each next one an ANHD header and
+ * a DLTA chunk of the bytes changed since the frame before the previous one (ANHD interleave 0 or 2) or since the
+ * previous one (interleave 1). Supports the vertical deltas of operation 5 (bytes) and 7 (shorts or longs, the
+ * opcodes and the data in separate lists).
+ * The deltas are applied to two planar buffers shown in turn, like the double-buffered display they were made
+ * for, and only the part of the frame they change is converted into the indices of the image. The palette and
+ * the ranges stay the ones of the first frame. */
+class Anim {
+public:
+  /* a part of the image, in pixels */
+  struct Rect {
+    int x{0}, y{0}, width{0}, height{0};
+
+    [[nodiscard]] bool isEmpty() const { return width <= 0 || height <= 0; }
+    /* the smallest rect holding both */
+    [[nodiscard]] Rect united(const Rect &other) const;
+  };
+
+  /* a part of the planes: rows [top, bottom) and line bytes [left, right) */
+  struct Bounds {
+    std::size_t top{0}, bottom{0}, left{0}, right{0};
+
+    [[nodiscard]] bool isEmpty() const { return top >= bottom || left >= right; }
+    /* grows to hold other too */
+    void add(const Bounds &other);
+  };
+
+  /* true when data is a FORM ANIM */
+  static bool isAnim(Span<const std::uint8_t> data);
+
+  /* Reads the frames of an ANIM file whose first frame is image, as loaded by IlbmLoader. The indices of image
+   * are copied when they are a view, the frames are written into them; its storage is kept since a progress
+   * may still read the view. Throws std::runtime_error when file isn't
+   * an ANIM or when its deltas aren't supported. */
+  Anim(std::shared_ptr<const MappedFile> file, Ilbm &image);
+
+  [[nodiscard]] std::size_t getNumFrames() const { return m_frames.size() + 1; }
+  [[nodiscard]] std::size_t getFrame() const { return m_frame; }
+  /* ticks (1/60 s) before the next frame, at least 1 */
+  [[nodiscard]] int getDelay() const;
+
+  /* Shows the next frame in image, the first one again after the last one. Returns the part of the image
+   * whose indices may have changed, the whole rows for the HAM images whose rgb rows are resolved again.
+   * Throws std::runtime_error when a delta runs past its chunk or the image. */
+  Rect next(Ilbm &image);
+
+private:
+  struct Frame {
+    Span<const std::uint8_t> delta;
+    std::uint8_t operation{0};
+    std::uint8_t interleave{0};
+    std::uint32_t bits{0};
+    int delay{1};
+  };
+
+  void convert(const Rect &rect, Ilbm &image) const;
+
+private:
+  std::shared_ptr<const MappedFile> m_file;
+  std::vector<Frame> m_frames;
+  int m_numPlanes{0};
+  std::size_t m_lineSize{0};
+  std::size_t m_planeSize{0};
+  /* the planes of the first frame, one after the other, and the two buffers frame n is decoded into n % 2 */
+  std::vector<std::uint8_t> m_first;
+  std::array<std::vector<std::uint8_t>, 2> m_buffers;
+  std::size_t m_frame{0};
+  /* where the buffers differ, the shown frame from the one before it */
+  Bounds m_changed;
+};
+
+#endif//COLORCYCLING__ANIM_H
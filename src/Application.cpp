@@ -1,8 +1,10 @@
 #include "Application.h"
 #include "StopWatch.h"
+#include "Trace.h"
 #include <imgui.h>
 #include <imgui/examples/imgui_impl_opengl3.h>
 #include <imgui/examples/imgui_impl_sdl.h>
+#include <iostream>
 #include <utility>
 
 namespace {
@@ -15,6 +17,11 @@ Application::~Application() = default;
 
 void Application::run() {
   onInit();
+  if (m_benchmarkFrames > 0) {
+    runBenchmark();
+    onExit();
+    return;
+  }
   processEvents();
 
   int frames = 0;
@@ -23,11 +30,14 @@ void Application::run() {
   auto timeSinceLastUpdate = TimeSpan::Zero;
   // Main loop
   while (!m_done) {
+    m_profiler.beginFrame();
     auto elapsed = stopWatch.restart();
     timeSinceLastUpdate += elapsed;
     while (timeSinceLastUpdate > TimePerFrame) {
       timeSinceLastUpdate -= TimePerFrame;
       processEvents();
+      FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Update);
+      TRACE_SCOPE("onUpdate");
       onUpdate(TimePerFrame);
     }
 
@@ -37,15 +47,57 @@ void Application::run() {
       frames = 0;
     }
 
-    onRender();
+    {
+      TRACE_SCOPE("onRender");
+      onRender();
+    }
     frames++;
-    m_window.display();
+    {
+      FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Swap);
+      m_window.display();
+    }
+    m_profiler.endFrame();
   }
 
   onExit();
 }
 
+void Application::runBenchmark() {
+  // no vsync and exactly one update per frame, the frames are only bound by the work done
+  m_window.setVerticalSyncEnabled(false);
+  m_profiler.setRecording(true);
+  for (auto frame = 0; frame < m_benchmarkFrames && !m_done; frame++) {
+    m_profiler.beginFrame();
+    processEvents();
+    {
+      FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Update);
+      TRACE_SCOPE("onUpdate");
+      onUpdate(TimePerFrame);
+    }
+    {
+      TRACE_SCOPE("onRender");
+      onRender();
+    }
+    {
+      FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Swap);
+      m_window.display();
+    }
+    m_profiler.endFrame();
+  }
+  m_profiler.setRecording(false);
+
+  const auto &frames = m_profiler.getFrames();
+  auto total = 0.0;
+  for (const auto &frame : frames) {
+    total += frame.total;
+  }
+  std::cout << frames.size() << " frames in " << total / 1000.0 << " s (" << (total > 0 ? frames.size() * 1000.0 / total : 0.0) << " frames/s)\n";
+  m_profiler.printSummary(std::cout);
+}
+
 void Application::processEvents() {
+  TRACE_SCOPE("processEvents");
+  FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Events);
   SDL_Event event;
   while (m_window.pollEvent(event)) {
     ImGui_ImplSDL2_ProcessEvent(&event);
@@ -70,14 +122,18 @@ void Application::onUpdate(const TimeSpan &) {
 }
 
 void Application::onRender() {
-  // Render dear imgui
-  ImGui_ImplOpenGL3_NewFrame();
-  ImGui_ImplSDL2_NewFrame(m_window.getNativeHandle());
-  ImGui::NewFrame();
-
-  onImGuiRender();
+  {
+    FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::ImGuiBuild);
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplSDL2_NewFrame(m_window.getNativeHandle());
+    ImGui::NewFrame();
+
+    TRACE_SCOPE("onImGuiRender");
+    onImGuiRender();
+  }
 
   // imgui render
+  FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::ImGuiRender);
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -1,6 +1,7 @@
 #ifndef COLORCYCLING__APPLICATION_H
 #define COLORCYCLING__APPLICATION_H
 
+#include "FrameProfiler.h"
 #include "TimeSpan.h"
 #include "Window.h"
 
@@ -10,6 +11,8 @@ public:
   virtual ~Application();
 
   void run();
+  /* runs frames frames as fast as possible with one update each and prints the time spent by each phase */
+  void setBenchmark(int frames) { m_benchmarkFrames = frames; }
 
 protected:
   virtual void onInit();
@@ -21,9 +24,12 @@ protected:
 
 private:
   void processEvents();
+  void runBenchmark();
 
 protected:
   Window m_window;
+  FrameProfiler m_profiler;
+  int m_benchmarkFrames{0};
   bool m_done{false};
   float m_fps{0};
   int m_frames{0};
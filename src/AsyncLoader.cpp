@@ -0,0 +1,54 @@
+#include "AsyncLoader.h"
+#include "IlbmLoader.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+/* images decoded at the same time, each of them can still use the shared pool for its rows */
+constexpr unsigned MaxConcurrentLoads = 4;
+}// namespace
+
+// at least one worker even on a single core, a load never runs on the main thread
+AsyncLoader::AsyncLoader(SceneCache *cache) : m_cache(cache), m_pool(std::clamp(std::thread::hardware_concurrency(), 1u, MaxConcurrentLoads)) {}
+
+void AsyncLoader::load(const std::string &path) {
+  auto load = std::make_shared<Load>();
+  auto done = m_pool.submit([path, load, cache = m_cache] {
+    TRACE_SCOPE("AsyncLoader::load");
+    if (cache) {
+      cache->load(path, load->image, load->progress);
+    } else {
+      IlbmLoader::load(path, load->image, load->progress);
+    }
+  });
+  m_pending.push_back({path, std::move(load), std::move(done)});
+}
+
+bool AsyncLoader::poll(Result &result) {
+  if (m_pending.empty() || m_pending.front().done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return false;
+
+  auto pending = std::move(m_pending.front());
+  m_pending.pop_front();
+  result.path = pending.path;
+  result.image.reset();
+  result.error.clear();
+  result.progress = std::shared_ptr<const IlbmLoader::Progress>(pending.load, &pending.load->progress);
+  try {
+    pending.done.get();
+    // moving the image keeps its pixels where the progress points
+    result.image = std::make_unique<Ilbm>(std::move(pending.load->image));
+  } catch (const std::exception &e) {
+    result.error = e.what();
+  }
+  return true;
+}
+
+std::shared_ptr<const IlbmLoader::Progress> AsyncLoader::getNextProgress() const {
+  if (m_pending.empty())
+    return nullptr;
+  const auto &load = m_pending.front().load;
+  return {load, &load->progress};
+}
@@ -0,0 +1,56 @@
+#ifndef COLORCYCLING__ASYNCLOADER_H
+#define COLORCYCLING__ASYNCLOADER_H
+
+#include "Ilbm.h"
+#include "IlbmLoader.h"
+#include "SceneCache.h"
+#include "ThreadPool.h"
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+
+/* loads images on worker threads, several at once, the results are taken on the main thread in the order
+ * of the requests */
+class AsyncLoader {
+public:
+  struct Result {
+    std::string path;
+    std::unique_ptr<Ilbm> image; /* null when the load failed */
+    std::string error;
+    /* the progress of the load, the pixels it points to are the ones of image */
+    std::shared_ptr<const IlbmLoader::Progress> progress;
+  };
+
+  /* the images are loaded through cache when there is one */
+  explicit AsyncLoader(SceneCache *cache = nullptr);
+
+  /* queues the load of path */
+  void load(const std::string &path);
+  /* takes the next finished load, in the order of the requests, returns false when it isn't done yet */
+  bool poll(Result &result);
+  /* number of loads queued or running */
+  [[nodiscard]] std::size_t getNumPending() const { return m_pending.size(); }
+  /* progress of the load poll will return next, null when there is none. It keeps the pixels it
+   * points to alive, until poll moves them to the result of a successful load. */
+  [[nodiscard]] std::shared_ptr<const IlbmLoader::Progress> getNextProgress() const;
+
+private:
+  /* shared with the task decoding it */
+  struct Load {
+    Ilbm image;
+    IlbmLoader::Progress progress;
+  };
+
+  struct Pending {
+    std::string path;
+    std::shared_ptr<Load> load;
+    std::future<void> done;
+  };
+
+  SceneCache *m_cache;
+  ThreadPool m_pool;
+  std::deque<Pending> m_pending;
+};
+
+#endif//COLORCYCLING__ASYNCLOADER_H
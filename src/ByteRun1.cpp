@@ -0,0 +1,79 @@
+#include "ByteRun1.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ByteRun1 {
+namespace {
+/* Away from the ends of the buffers runs are copied by blocks of a fixed size, inlined by the compiler,
+ * the bytes written past a run are overwritten by the next runs. A run is at most 128 bytes. */
+constexpr std::size_t Block = 32;
+constexpr std::size_t Margin = 128 + Block;
+}// namespace
+
+DecodeResult decode(Span<const std::uint8_t> source, std::uint8_t *destination, std::size_t size) {
+  const auto *src = source.data();
+  const auto srcSize = source.size();
+  std::size_t in = 0, out = 0;
+  while (in < srcSize && out < size) {
+    const auto n = static_cast<std::int8_t>(src[in++]);
+    if (n >= 0) {
+      /* [0..127]   : followed by n+1 bytes of data. */
+      const auto count = std::min({static_cast<std::size_t>(n) + 1, srcSize - in, size - out});
+      if (srcSize - in >= Margin && size - out >= Margin) {
+        for (std::size_t i = 0; i < count; i += Block) {
+          std::memcpy(destination + out + i, src + in + i, Block);
+        }
+      } else {
+        std::memcpy(destination + out, src + in, count);
+      }
+      in += count;
+      out += count;
+    } else if (n != -128) {
+      /* [-1..-127] : followed by byte to be repeated (-n)+1 times*/
+      if (in == srcSize)
+        break;
+      const auto count = std::min(static_cast<std::size_t>(1 - n), size - out);
+      if (size - out >= Margin) {
+        for (std::size_t i = 0; i < count; i += Block) {
+          std::memset(destination + out + i, src[in], Block);
+        }
+      } else {
+        std::memset(destination + out, src[in], count);
+      }
+      in++;
+      out += count;
+    }
+    /* -128	   : NOOP. */
+  }
+  return {in, out};
+}
+
+bool findRows(Span<const std::uint8_t> source, std::size_t rowSize, std::size_t numRows, std::vector<std::size_t> &offsets) {
+  offsets.resize(numRows + 1);
+  const auto srcSize = source.size();
+  std::size_t in = 0;
+  for (std::size_t row = 0; row < numRows; row++) {
+    offsets[row] = in;
+    std::size_t out = 0;
+    while (out < rowSize) {
+      if (in == srcSize)
+        return false;
+      const auto n = static_cast<std::int8_t>(source[in++]);
+      // the data of the run must be in the source before it is skipped
+      const std::size_t count = n >= 0 ? static_cast<std::size_t>(n) + 1 : n != -128 ? 1 : 0;
+      if (count > srcSize - in)
+        return false;
+      if (n >= 0) {
+        out += count;
+      } else if (n != -128) {
+        out += static_cast<std::size_t>(1 - n);
+      }
+      in += count;
+    }
+    if (out != rowSize)
+      return false;
+  }
+  offsets[numRows] = in;
+  return true;
+}
+}// namespace ByteRun1
@@ -0,0 +1,27 @@
+#ifndef COLORCYCLING__BYTERUN1_H
+#define COLORCYCLING__BYTERUN1_H
+
+#include "Span.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* ByteRun1 (PackBits) compression of the IFF BODY chunks */
+namespace ByteRun1 {
+struct DecodeResult {
+  std::size_t read{0};    /* bytes consumed from the source */
+  std::size_t written{0}; /* bytes written to the destination */
+};
+
+/* Decodes until the source is exhausted or size bytes have been written, a run cut by either end is truncated.
+ * Never reads or writes out of bounds whatever the source contains, the bytes of destination after the ones
+ * written may be modified too. */
+DecodeResult decode(Span<const std::uint8_t> source, std::uint8_t *destination, std::size_t size);
+
+/* Finds where each of numRows rows of rowSize bytes starts in source by reading only the run headers,
+ * offsets gets numRows + 1 entries. Returns false when a run crosses the end of a row or the source is
+ * too short, the rows can't be decoded independently then. */
+bool findRows(Span<const std::uint8_t> source, std::size_t rowSize, std::size_t numRows, std::vector<std::size_t> &offsets);
+}// namespace ByteRun1
+
+#endif//COLORCYCLING__BYTERUN1_H
@@ -0,0 +1,126 @@
+#include "ColorCycler.h"
+#include "ViewModes.h"
+#include <algorithm>
+#include <cmath>
+
+std::int32_t cycleOffset(int mode, std::int32_t rate, std::int32_t rsize, std::int32_t msec, float speed) {
+  float offs;
+  float tm = (rate / 280.0f) * static_cast<float>(msec * speed) / 1000.0f;
+
+  switch (mode) {
+  case CYCLE_PINGPONG:
+    offs = fmod(tm, static_cast<float>(rsize * 2));
+    if (offs >= rsize)
+      offs = static_cast<float>(rsize * 2) - offs;
+    break;
+
+  case CYCLE_SINE:
+  case CYCLE_SINE_HALF: {
+    float x = fmod(tm, static_cast<float>(rsize));
+    offs = sinf((x * static_cast<float>(M_PI) * 2.0f) / static_cast<float>(rsize)) + 1.0f;
+    offs *= rsize / (mode == CYCLE_SINE_HALF ? 4.0f : 2.0f);
+  } break;
+
+  default: /* normal or reverse */
+    offs = tm;
+  }
+  return (int32_t)(offs * 256.0f);
+}
+
+void ColorCycler::setBasePalette(const std::array<std::uint8_t, 256 * 3> &palette) {
+  m_palette = palette;
+}
+
+void ColorCycler::restart() {
+  m_timeMsec = 0;
+  m_tick = 0;
+}
+
+bool ColorCycler::setPalette(Ilbm &img, int idx, std::uint8_t r, std::uint8_t g, std::uint8_t b) const {
+  if (m_lockedIndex == idx)
+    return false;
+  auto *pptr = &img.palette[0] + idx * 3;
+  const auto changed = pptr[0] != r || pptr[1] != g || pptr[2] != b;
+  pptr[0] = r;
+  pptr[1] = g;
+  pptr[2] = b;
+  return changed;
+}
+
+bool ColorCycler::step(Ilbm &image) {
+  // the baked palettes are the ones cycled below from the start, at speed 1
+  const auto tick = m_tick++;
+  const auto numBakedTicks = image.bakedPalettes.size() / image.palette.size();
+  if (tick < numBakedTicks && m_speed == 1.f && m_blend == image.bakedBlend && m_lockedIndex == -1) {
+    const auto *baked = image.bakedPalettes.data() + tick * image.palette.size();
+    const auto changed = !std::equal(baked, baked + image.palette.size(), image.palette.begin());
+    std::copy_n(baked, image.palette.size(), image.palette.data());
+    // the clock goes on as if the ranges had been cycled
+    for (auto i = 0; i < image.numCycles; i++) {
+      if (image.cycles[i].rate)
+        m_timeMsec += 100.0f / 60.f;
+    }
+    if (changed && image.isExtraHalfBrite())
+      ViewModes::extendHalfBrite(image.palette);
+    return changed;
+  }
+
+  auto changed = false;
+  /* for each cycling range in the image ... */
+  for (auto i = 0; i < image.numCycles; i++) {
+    int32_t offs, rsize, ioffs;
+    int rev;
+
+    if (!image.cycles[i].rate)
+      continue;
+    rsize = image.cycles[i].high - image.cycles[i].low + 1;
+
+    m_timeMsec += 100.0f / 60.f;
+
+    offs = cycleOffset(image.cycles[i].flags, image.cycles[i].rate, rsize, m_timeMsec, m_speed);
+
+    ioffs = (offs >> 8) % rsize;
+
+    /* reverse when rev is 2 */
+    rev = image.cycles[i].flags == CYCLE_REVERSE ? 1 : 0;
+
+    for (auto j = 0; j < rsize; j++) {
+      int pidx, to, next;
+
+      pidx = j + image.cycles[i].low;
+
+      if (rev) {
+        to = (j + ioffs) % rsize;
+        next = (to + 1) % rsize;
+      } else {
+        if ((to = (j - ioffs) % rsize) < 0) {
+          to += rsize;
+        }
+        if ((next = to - 1) < 0) {
+          next += rsize;
+        }
+      }
+      to += image.cycles[i].low;
+
+      if (m_blend) {
+        int r, g, b;
+        auto fracOffs = static_cast<int32_t>(offs & 0xff);
+
+        next += image.cycles[i].low;
+
+        r = lerp(m_palette[to * 3], m_palette[next * 3], fracOffs);
+        g = lerp(m_palette[to * 3 + 1], m_palette[next * 3 + 1], fracOffs);
+        b = lerp(m_palette[to * 3 + 2], m_palette[next * 3 + 2], fracOffs);
+
+        changed |= setPalette(image, pidx, r, g, b);
+      } else {
+        changed |= setPalette(image, pidx, m_palette[to * 3], m_palette[to * 3 + 1], m_palette[to * 3 + 2]);
+      }
+    }
+  }
+
+  // the half-brite colors follow the colors they are made of
+  if (changed && image.isExtraHalfBrite())
+    ViewModes::extendHalfBrite(image.palette);
+  return changed;
+}
@@ -0,0 +1,59 @@
+#ifndef COLORCYCLING__COLORCYCLER_H
+#define COLORCYCLING__COLORCYCLER_H
+
+#include "Ilbm.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+constexpr int CYCLE_NORMAL = 0;
+constexpr int CYCLE_REVERSE = 2;
+constexpr int CYCLE_PINGPONG = 3;
+constexpr int CYCLE_SINE_HALF = 4; /* sine -> [0, range/2] */
+constexpr int CYCLE_SINE = 5;      /* sine -> [0, range] */
+
+/* returns the offset of a cycling range in 24.8 fixed point */
+std::int32_t cycleOffset(int mode, std::int32_t rate, std::int32_t rsize, std::int32_t msec, float speed);
+
+inline std::uint8_t lerp(std::uint8_t a, std::uint8_t b, std::int32_t xt) {
+  return ((((a) << 8) + ((b) - (a)) * (xt)) >> 8);
+}
+
+/* Steps the CRNG ranges of an image: the cycled colors are computed from
+ * the base palette and written into Ilbm::palette, or copied from the palettes baked for the first ticks. */
+class ColorCycler {
+public:
+  void setBasePalette(const std::array<std::uint8_t, 256 * 3> &palette);
+  /* cycles from the first tick again, the one the baked palettes start at */
+  void restart();
+  /* advances all the cycling ranges by one fixed tick (1/60 s), returns true when a color of the palette
+   * changed */
+  bool step(Ilbm &image);
+
+  [[nodiscard]] const std::array<std::uint8_t, 256 * 3> &getBasePalette() const { return m_palette; }
+
+  [[nodiscard]] bool getBlend() const { return m_blend; }
+  void setBlend(bool blend) { m_blend = blend; }
+
+  [[nodiscard]] float getSpeed() const { return m_speed; }
+  void setSpeed(float speed) { m_speed = speed; }
+
+  /* a locked color index is never overwritten by the cycling (-1 for none) */
+  [[nodiscard]] int getLockedIndex() const { return m_lockedIndex; }
+  void setLockedIndex(int index) { m_lockedIndex = index; }
+
+private:
+  /* returns true when the color changed */
+  bool setPalette(Ilbm &img, int idx, std::uint8_t r, std::uint8_t g, std::uint8_t b) const;
+
+private:
+  std::array<std::uint8_t, 256 * 3> m_palette{};
+  float m_timeMsec{0};
+  /* ticks stepped since the start */
+  std::size_t m_tick{0};
+  bool m_blend{true};
+  float m_speed{1.f};
+  int m_lockedIndex{-1};
+};
+
+#endif//COLORCYCLING__COLORCYCLER_H
@@ -1,85 +1,21 @@
 #include "ColorCyclingApplication.h"
-#include "Util.h"
-#include <GL/glew.h>
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include "Trace.h"
+#include "ViewModes.h"
 #include <ImGuiFileDialog/ImGuiFileDialog.h>
 #include <SDL.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <imgui.h>
 #include <iostream>
-
-const float fbwidth = 640;
-const float fbheight = 480;
-
-const char *vertexShaderSource = "#version 330 core\n"
-                                 "uniform mat4 xform;\n"
-                                 "layout (location = 0) in vec4 attr_vertex;\n"
-                                 "in vec2 uvscale;\n"
-                                 "out vec2 uv;\n"
-                                 "void main()\n"
-                                 "{\n"
-                                 "   gl_Position = xform * attr_vertex;\n"
-                                 "   uv = (attr_vertex.xy * vec2(0.5, -0.5) + 0.5) * uvscale;\n"
-                                 "}\0";
-const char *fragmentShaderSource = "#version 330 core\n"
-                                   "out vec4 FragColor;\n"
-                                   "in vec2 uv;\n"
-                                   "uniform sampler2D img_tex;\n"
-                                   "uniform sampler1D pal_tex;\n"
-                                   "void main()\n"
-                                   "{\n"
-                                   "  float cidx = texture(img_tex, uv).x;\n"
-                                   "  vec3 color = texture(pal_tex, cidx).xyz;\n"
-                                   "  FragColor.xyz = color;\n"
-                                   "  FragColor.a = 1.0;\n"
-                                   "}\n\0";
-
-const int CYCLE_NORMAL = 0;
-const int CYCLE_REVERSE = 2;
-const int CYCLE_PINGPONG = 3;
-const int CYCLE_SINE_HALF = 4; /* sine -> [0, range/2] */
-const int CYCLE_SINE = 5;      /* sine -> [0, range] */
-
-constexpr float vertices[] = {
-    1.0f, 1.0f, 0.0f, 0.0f,  // top right
-    1.0f, -1.0f, 0.0f, 0.0f, // bottom right
-    -1.0f, -1.0f, 0.0f, 0.0f,// bottom left
-    -1.0f, 1.0f, 0.0f, 0.0f  // top left
-};
-
-constexpr unsigned int indices[] = {
-    // note that we start from 0!
-    0, 1, 3,// first triangle
-    1, 2, 3 // second triangle
-};
-
-static int32_t cycleOffset(int mode, int32_t rate, int32_t rsize, int32_t msec, float speed) {
-  float offs;
-  float tm = (rate / 280.0f) * static_cast<float>(msec * speed) / 1000.0f;
-
-  switch (mode) {
-  case CYCLE_PINGPONG:
-    offs = fmod(tm, static_cast<float>(rsize * 2));
-    if (offs >= rsize)
-      offs = static_cast<float>(rsize * 2) - offs;
-    break;
-
-  case CYCLE_SINE:
-  case CYCLE_SINE_HALF: {
-    float x = fmod(tm, static_cast<float>(rsize));
-    offs = sinf((x * static_cast<float>(M_PI) * 2.0f) / static_cast<float>(rsize)) + 1.0f;
-    offs *= rsize / (mode == CYCLE_SINE_HALF ? 4.0f : 2.0f);
-  } break;
-
-  default: /* normal or reverse */
-    offs = tm;
-  }
-  return (int32_t)(offs * 256.0f);
-}
-
-static std::uint8_t lerp(std::uint8_t a, std::uint8_t b, std::int32_t xt) {
-  return ((((a) << 8) + ((b) - (a)) * (xt)) >> 8);
-}
+#include <sstream>
+#include <utility>
 
 static int drawPalette(const std::uint8_t *palette, int numColorsByRow = 13, const ImVec2 &size = ImVec2(12, 12), const ImVec2 &spacing = ImVec2(2, 2)) {
   auto pos = ImGui::GetCursorScreenPos();
@@ -109,188 +45,251 @@ static int drawPalette(const std::uint8_t *palette, int numColorsByRow = 13, con
   return index == -1 ? -1 : index - 1;
 }
 
-ColorCyclingApplication::ColorCyclingApplication() = default;
+static const char *TimingsPath = "frame_timings.csv";
+/* time spent uploading the rows of an image being loaded, by frame */
+static constexpr std::chrono::microseconds UploadBudget{4000};
+/* bytes uploaded at once, about a quarter of a 1920x1080 image of indices */
+static constexpr std::size_t UploadStripeSize = 512 * 1024;
+/* side of the thumbnails in the file dialog and width of their pane */
+static constexpr float ThumbnailSize = 64.f;
+static constexpr std::size_t ThumbnailPaneWidth = 300;
+
+struct PlotSource {
+  const FrameProfiler *profiler;
+  int phase;/* -1 for the whole frame */
+};
+
+static float getFrameTime(void *data, int index) {
+  const auto &source = *static_cast<PlotSource *>(data);
+  const auto &frame = source.profiler->getHistoryFrame(index);
+  return static_cast<float>(source.phase < 0 ? frame.total : frame.phases[source.phase]);
+}
 
-ColorCyclingApplication::~ColorCyclingApplication() {
-  glDeleteVertexArrays(1, &m_vao);
-  glDeleteBuffers(1, &m_vbo);
-  glDeleteBuffers(1, &m_ebo);
+/* one plot of the last frames by phase, with the last, mean and max values */
+static void drawTimings(const FrameProfiler &profiler) {
+  const auto size = static_cast<int>(profiler.getHistorySize());
+  if (size == 0)
+    return;
+  for (auto phase = -1; phase < FrameProfiler::NumPhases; phase++) {
+    PlotSource source{&profiler, phase};
+    auto max = 0.f, sum = 0.f;
+    for (auto i = 0; i < size; i++) {
+      auto value = getFrameTime(&source, i);
+      max = std::max(max, value);
+      sum += value;
+    }
+    char overlay[64];
+    sprintf(overlay, "%.2f ms (mean %.2f, max %.2f)", getFrameTime(&source, size - 1), sum / static_cast<float>(size), max);
+    const auto *name = phase < 0 ? "frame" : FrameProfiler::getPhaseName(static_cast<FrameProfiler::Phase>(phase));
+    ImGui::PlotLines(name, getFrameTime, &source, size, 0, overlay, 0.f, std::max(max, 1.f), ImVec2(0, phase < 0 ? 60.f : 30.f));
+  }
 }
 
+ColorCyclingApplication::ColorCyclingApplication(std::string path) : m_initialPath(std::move(path)) {}
+
+ColorCyclingApplication::~ColorCyclingApplication() = default;
+
 void ColorCyclingApplication::onInit() {
   Application::onInit();
-  int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-  glCompileShader(vertexShader);
-  // check for shader compile errors
-  int success;
-  char infoLog[512];
-  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
-    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-              << infoLog << std::endl;
-  }
-  // fragment shader
-  int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-  glCompileShader(fragmentShader);
-  // check for shader compile errors
-  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-  if (!success) {
-    glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
-    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-              << infoLog << std::endl;
+  m_renderer.init();
+  if (m_initialPath.empty())
+    return;
+  // the benchmark needs its image before the first frame
+  if (m_benchmarkFrames == 0) {
+    m_loader.load(m_initialPath);
+  } else if (!loadLbm(m_initialPath)) {
+    std::ostringstream ss;
+    ss << "Error when loading " << m_initialPath << " for the benchmark";
+    throw std::runtime_error(ss.str());
   }
-  // link shaders
-  m_shaderProgram = glCreateProgram();
-  glAttachShader(m_shaderProgram, vertexShader);
-  glAttachShader(m_shaderProgram, fragmentShader);
-  glLinkProgram(m_shaderProgram);
-  // check for linking errors
-  glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &success);
-  if (!success) {
-    glGetProgramInfoLog(m_shaderProgram, 512, nullptr, infoLog);
-    std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-              << infoLog << std::endl;
+}
+
+bool ColorCyclingApplication::loadLbm(const std::string &path) {
+  TRACE_SCOPE("loadLbm");
+  std::unique_ptr<Ilbm> image;
+  try {
+    image = m_cache.load(path);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return false;
   }
-  glDeleteShader(vertexShader);
-  glDeleteShader(fragmentShader);
-
-  glGenVertexArrays(1, &m_vao);
-  glGenBuffers(1, &m_vbo);
-  glGenBuffers(1, &m_ebo);
-  // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-  glBindVertexArray(m_vao);
-
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-  // position attribute
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
-  glEnableVertexAttribArray(0);
-
-  auto tex_xsz = Util::nextPow2(fbwidth);
-  auto tex_ysz = Util::nextPow2(fbheight);
-
-  glGenTextures(1, &m_img_tex);
-  glBindTexture(GL_TEXTURE_2D, m_img_tex);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, tex_xsz, tex_ysz, 0, GL_RED, GL_UNSIGNED_BYTE, 0);
-
-  glGenTextures(1, &m_pal_tex);
-  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
-  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-
-  glUseProgram(m_shaderProgram);
-  glUniform1i(glGetUniformLocation(m_shaderProgram, "img_tex"), 0);
-  glUniform1i(glGetUniformLocation(m_shaderProgram, "pal_tex"), 1);
-  glVertexAttrib2f(glGetAttribLocation(m_shaderProgram, "uvscale"), (float) fbwidth / (float) tex_xsz, (float) fbheight / (float) tex_ysz);
+  setImage(std::move(image));
+  openAnim(path);
+  return true;
 }
 
-void ColorCyclingApplication::loadLbm(const std::string &path) {
-  m_image = std::make_unique<Ilbm>();
-  auto &image = *m_image;
-  std::ifstream is(path, std::ios::binary);
-
-  Chunk chunk{};
-  std::uint8_t *temp;
-  int bodyBytes = 0;
-  constexpr auto chunkSize = sizeof(Chunk);
-  is.read((char *) &chunk, chunkSize);
-
-  Util::endianSwap((int32_t *) &chunk.length);
-
-  // skip over 'PBM '
-  is.seekg(4, std::ios::cur);
-
-  while (!is.eof()) {
-    is.read((char *) &chunk, chunkSize);
-    Util::endianSwap((int32_t *) &chunk.length);
-    if (strncmp(chunk.id, "BMHD", 4) == 0) {
-      is.read((char *) &image.header, sizeof(image.header));
-      Util::endianSwap(&image.header.width);
-      Util::endianSwap(&image.header.height);
-      Util::endianSwap(&image.header.page_width);
-      Util::endianSwap(&image.header.page_height);
-      image.header.width += (2 - (image.header.width % 2)) % 2;// even widths only (round up)
-    } else if (strncmp(chunk.id, "CMAP", 4) == 0) {
-      is.read((char *) &image.palette[0], chunk.length);
-    } else if (strncmp(chunk.id, "CRNG", 4) == 0) {
-      is.read((char *) &image.cycles[image.numCycles], chunk.length);
-      Util::endianSwap(&image.cycles[image.numCycles].padding);
-      Util::endianSwap(&image.cycles[image.numCycles].rate);
-      Util::endianSwap(&image.cycles[image.numCycles].flags);
-      image.numCycles++;
-    } else if (strncmp(chunk.id, "BODY", 4) == 0) {
-      if (image.header.compression) {
-        image.image.resize(image.header.width * image.header.height);
-        temp = image.image.data();
-        signed char sdata;
-        auto len = chunk.length;
-        is.read((char *) &sdata, 1);
-        while (len > 0 && !is.eof()) {
-          len--;
-          /* ByteRun1 decompression */
-
-          /* [0..127]   : followed by n+1 bytes of data. */
-          if (sdata >= 0) {
-            auto i = sdata + 1;
-            for (auto j = 0; j < i; j++) {
-              char udata;
-              is.read(&udata, 1);
-              len--;
-              if (is.eof())
-                break;
-              *temp++ = udata;
-              bodyBytes++;
-            }
-          }
-          /* [-1..-127] : followed by byte to be repeated (-n)+1 times*/
-          else if (sdata <= -1 && sdata >= -127) {
-            auto i = (-sdata) + 1;
-            char udata;
-            is.read(&udata, 1);
-            len--;
-            for (auto j = 0; j < i; j++) {
-              *temp++ = udata;
-              bodyBytes++;
-            }
-          }
-          /* -128	   : NOOP. */
-          is.read((char *) &sdata, 1);
-        }
-      }
-      memcpy(&m_palette[0], &image.palette[0], 256 * 3);
-      glBindTexture(GL_TEXTURE_2D, m_img_tex);
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fbwidth, fbheight, GL_RED, GL_UNSIGNED_BYTE, image.image.data());
-      glBindTexture(GL_TEXTURE_1D, m_pal_tex);
-      glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, image.palette.data());
+void ColorCyclingApplication::updateLoads() {
+  std::unique_ptr<Ilbm> image;
+  std::shared_ptr<const IlbmLoader::Progress> progress;
+  std::string path;
+  auto streamFailed = false;
+  AsyncLoader::Result result;
+  while (m_loader.poll(result)) {
+    if (result.image) {
+      image = std::move(result.image);
+      progress = std::move(result.progress);
+      path = std::move(result.path);
     } else {
-      if (chunk.length > 0)
-        is.seekg(chunk.length, std::ios::cur);
+      std::cerr << result.error << std::endl;
+      streamFailed = streamFailed || (m_streamed && result.progress == m_streamed);
     }
-    if (chunk.length % 2 != 0)
-      is.seekg(2 - (chunk.length % 2), std::ios::cur);
   }
 
-  is.close();
+  if (image && m_streamed && progress == m_streamed && image->isTrueColor() == m_streamed->trueColor) {
+    // its texture is already there, the rows still missing are uploaded below
+    m_image = std::move(image);
+    m_cycler.setBasePalette(m_image->palette);
+    m_previewing = false;
+    openAnim(path);
+  } else if (image) {
+    m_streamed.reset();
+    m_previewing = false;
+    setImage(std::move(image));
+    openAnim(path);
+  } else if (streamFailed) {
+    m_streamed.reset();
+    m_previewing = false;
+    if (m_image) {
+      m_renderer.setImage(*m_image);
+    } else {
+      m_renderer.clearImage();
+    }
+  }
+
+  // the image loading first is shown as its rows are decoded
+  if (!m_streamed) {
+    auto next = m_loader.getNextProgress();
+    if (!next || !next->started.load(std::memory_order_acquire))
+      return;
+    m_streamed = std::move(next);
+    m_uploadedRows = 0;
+    m_previewing = true;
+    m_renderer.beginImage(m_streamed->header.width, m_streamed->header.height, m_streamed->trueColor, m_streamed->palette.data());
+  }
+  uploadStreamedRows();
 }
 
-void ColorCyclingApplication::setPalette(Ilbm &img, int idx, std::uint8_t r, std::uint8_t g, std::uint8_t b) const {
-  if (m_currentColorIndex == idx)
+void ColorCyclingApplication::uploadStreamedRows() {
+  const auto stride = m_streamed->stride;
+  const auto rowSize = stride * (m_streamed->trueColor ? 3 : 1);
+  const auto stripeRows = static_cast<int>(std::max<std::size_t>(1, UploadStripeSize / std::max<std::size_t>(rowSize, 1)));
+  const auto numRows = static_cast<int>(m_streamed->numRows.load(std::memory_order_acquire));
+  const auto start = std::chrono::steady_clock::now();
+  while (m_uploadedRows < numRows && std::chrono::steady_clock::now() - start < UploadBudget) {
+    const auto count = std::min(stripeRows, numRows - m_uploadedRows);
+    m_renderer.uploadRows(m_streamed->pixels, stride, m_uploadedRows, count);
+    m_uploadedRows += count;
+  }
+  if (!m_previewing && m_uploadedRows >= m_streamed->header.height)
+    m_streamed.reset();
+}
+
+void ColorCyclingApplication::setImage(std::unique_ptr<Ilbm> image) {
+  TRACE_SCOPE("setImage");
+  m_image = std::move(image);
+  m_cycler.setBasePalette(m_image->palette);
+  // from the first tick, which the baked palettes of a scene start at
+  m_cycler.restart();
+  m_renderer.setImage(*m_image);
+  m_paletteChanged = false;
+}
+
+void ColorCyclingApplication::openAnim(const std::string &path) {
+  m_anim.reset();
+  m_animTicks = 0;
+  m_animChanged = {};
+  try {
+    auto file = std::make_shared<const MappedFile>(path);
+    if (Anim::isAnim(file->getData()))
+      m_anim = std::make_unique<Anim>(std::move(file), *m_image);
+  } catch (const std::runtime_error &e) {
+    // the first frame stays, as a still image
+    std::cerr << path << ": " << e.what() << std::endl;
+  }
+}
+
+void ColorCyclingApplication::listImages(const std::string &directory) {
+  m_listedDirectory = directory;
+  m_listedImages.clear();
+  std::error_code error;
+  for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+    auto extension = it->path().extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    if ((extension == ".lbm" || extension == ".anm" || extension == ".anim" || extension == ".ccyc") && it->is_regular_file(error))
+      m_listedImages.push_back(it->path().string());
+  }
+  std::sort(m_listedImages.begin(), m_listedImages.end());
+}
+
+bool ColorCyclingApplication::drawThumbnail(const std::string &path, float size) {
+  ImGui::PushID(path.c_str());
+  const auto pos = ImGui::GetCursorScreenPos();
+  const auto max = ImVec2(pos.x + size, pos.y + size);
+  const auto clicked = ImGui::InvisibleButton("thumbnail", ImVec2(size, size));
+  ImGui::PopID();
+  auto drawList = ImGui::GetWindowDrawList();
+  if (ImGui::IsItemHovered()) {
+    drawList->AddRect(pos, max, ImColor(0.8f, 0.8f, 0.8f, 1.0f));
+    ImGui::SetTooltip("%s", std::filesystem::path(path).filename().string().c_str());
+  }
+
+  // the same gray as the rows not loaded yet until it is made
+  const auto thumbnail = m_thumbnails.get(path);
+  if (!thumbnail) {
+    drawList->AddRectFilled(ImVec2(pos.x + 1, pos.y + 1), ImVec2(max.x - 1, max.y - 1), ImColor(0.3f, 0.3f, 0.3f, 1.0f));
+    return clicked;
+  }
+  const auto texture = m_thumbnailTextures.get(path, thumbnail, m_animateThumbnails);
+  const auto scale = size / std::max(thumbnail->header.width, thumbnail->header.height);
+  const auto width = thumbnail->header.width * scale;
+  const auto height = thumbnail->header.height * scale;
+  const auto min = ImVec2(pos.x + (size - width) / 2, pos.y + (size - height) / 2);
+  drawList->AddImage(reinterpret_cast<ImTextureID>(static_cast<std::uintptr_t>(texture)), min, ImVec2(min.x + width, min.y + height));
+  return clicked;
+}
+
+void ColorCyclingApplication::drawThumbnails() {
+  auto dialog = igfd::ImGuiFileDialog::Instance();
+  const auto directory = dialog->GetCurrentPath();
+  if (directory != m_listedDirectory)
+    listImages(directory);
+
+  ImGui::Checkbox("Animate", &m_animateThumbnails);
+  const auto fileName = dialog->GetCurrentFileName();
+  if (!fileName.empty()) {
+    const auto path = (std::filesystem::path(directory) / fileName).string();
+    if (std::binary_search(m_listedImages.begin(), m_listedImages.end(), path) && drawThumbnail(path, ImGui::GetContentRegionAvail().x))
+      m_thumbnailChoice = path;
+  }
+  ImGui::Separator();
+
+  // only the visible rows request their thumbnails
+  ImGui::BeginChild("##thumbnails");
+  const auto spacing = ImGui::GetStyle().ItemSpacing;
+  const auto numColumns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + spacing.x) / (ThumbnailSize + spacing.x)));
+  const auto numImages = static_cast<int>(m_listedImages.size());
+  ImGuiListClipper clipper((numImages + numColumns - 1) / numColumns, ThumbnailSize + spacing.y);
+  while (clipper.Step()) {
+    for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+      for (auto i = row * numColumns; i < std::min(numImages, (row + 1) * numColumns); i++) {
+        if (i > row * numColumns)
+          ImGui::SameLine();
+        if (drawThumbnail(m_listedImages[i], ThumbnailSize))
+          m_thumbnailChoice = m_listedImages[i];
+      }
+    }
+  }
+  ImGui::EndChild();
+}
+
+void ColorCyclingApplication::saveTimings(const std::string &path) const {
+  std::ofstream file(path);
+  m_profiler.writeCsv(file);
+  if (!file) {
+    std::cerr << "Error when writing " << path << std::endl;
     return;
-  auto *pptr = &img.palette[0] + idx * 3;
-  pptr[0] = r;
-  pptr[1] = g;
-  pptr[2] = b;
+  }
+  std::cout << "frame timings written to " << path << std::endl;
 }
 
 void ColorCyclingApplication::onEvent(SDL_Event &event) {
@@ -298,10 +297,10 @@ void ColorCyclingApplication::onEvent(SDL_Event &event) {
   case SDL_WINDOWEVENT: {
     int w, h;
     SDL_GL_GetDrawableSize(m_window.getNativeHandle(), &w, &h);
-    reshape(w, h);
+    m_renderer.reshape(w, h);
     break;
   case SDL_DROPFILE:
-    loadLbm(event.drop.file);
+    m_loader.load(event.drop.file);
     SDL_free(event.drop.file);
     break;
   case SDL_KEYDOWN:
@@ -313,113 +312,67 @@ void ColorCyclingApplication::onEvent(SDL_Event &event) {
 }
 
 void ColorCyclingApplication::onRender() {
-  glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
-  glClear(GL_COLOR_BUFFER_BIT);
-
-  // bind textures on corresponding texture units
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, m_img_tex);
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
-
-  // draw our first triangle
-  glUseProgram(m_shaderProgram);
-  glBindVertexArray(m_vao);// seeing as we only have a single m_vao there's no need to bind it every time, but we'll do so to keep things a bit more organized
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+  {
+    FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Upload);
+    updateLoads();
+  }
+  // only the part of the image changed by the frames, the palette cycling goes on below
+  if (!m_animChanged.isEmpty() && !m_previewing) {
+    FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Upload);
+    const auto &rect = m_animChanged;
+    const auto *pixels = m_image->isTrueColor() ? m_image->rgb.data() : m_image->image.data();
+    m_renderer.uploadRect(pixels, m_image->stride(), rect.x, rect.y, rect.width, rect.height);
+    m_animChanged = {};
+  }
+  // the palette of the image being previewed stays the one it was loaded with
+  if (m_paletteChanged && !m_previewing) {
+    FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Upload);
+    if (m_image->isHam()) {
+      // the HAM colors come from the cycled palette, resolved again on the CPU
+      ViewModes::resolveHam(*m_image);
+      m_renderer.uploadRows(m_image->rgb.data(), m_image->stride(), 0, m_image->header.height);
+    } else {
+      m_renderer.updatePalette(*m_image);
+    }
+    m_paletteChanged = false;
+  }
+  {
+    FrameProfiler::Scope scope(m_profiler, FrameProfiler::Phase::Draw);
+    m_renderer.draw();
+  }
 
   Application::onRender();
 }
 
-void ColorCyclingApplication::onUpdate(const TimeSpan &elapsed) {
+void ColorCyclingApplication::onUpdate(const TimeSpan &) {
   if (!m_image)
     return;
 
-  auto &image = *m_image;
-  /* for each cycling range in the image ... */
-  for (auto i = 0; i < image.numCycles; i++) {
-    int32_t offs, rsize, ioffs;
-    int rev;
-
-    if (!image.cycles[i].rate)
-      continue;
-    rsize = image.cycles[i].high - image.cycles[i].low + 1;
-
-    time_msec += 100.0f / 60.f;
-
-    offs = cycleOffset(image.cycles[i].flags, image.cycles[i].rate, rsize, time_msec, m_speed);
-
-    ioffs = (offs >> 8) % rsize;
-
-    /* reverse when rev is 2 */
-    rev = image.cycles[i].flags == CYCLE_REVERSE ? 1 : 0;
-
-    for (auto j = 0; j < rsize; j++) {
-      int pidx, to, next;
-
-      pidx = j + image.cycles[i].low;
-
-      if (rev) {
-        to = (j + ioffs) % rsize;
-        next = (to + 1) % rsize;
-      } else {
-        if ((to = (j - ioffs) % rsize) < 0) {
-          to += rsize;
-        }
-        if ((next = to - 1) < 0) {
-          next += rsize;
-        }
-      }
-      to += image.cycles[i].low;
-
-      if (m_blend) {
-        int r, g, b;
-        auto fracOffs = static_cast<int32_t>(offs & 0xff);
-
-        next += image.cycles[i].low;
-
-        r = lerp(m_palette[to * 3], m_palette[next * 3], fracOffs);
-        g = lerp(m_palette[to * 3 + 1], m_palette[next * 3 + 1], fracOffs);
-        b = lerp(m_palette[to * 3 + 2], m_palette[next * 3 + 2], fracOffs);
-
-        setPalette(image, pidx, r, g, b);
-      } else {
-        setPalette(image, pidx, m_palette[to * 3], m_palette[to * 3 + 1], m_palette[to * 3 + 2]);
-      }
+  // the frames wait while another image is previewed, its texture is the one drawn
+  if (m_anim && !m_previewing && ++m_animTicks >= m_anim->getDelay()) {
+    m_animTicks = 0;
+    try {
+      m_animChanged = m_animChanged.united(m_anim->next(*m_image));
+    } catch (const std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+      m_anim.reset();
     }
   }
-  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
-  glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGB, GL_UNSIGNED_BYTE, &image.palette[0]);
-}
-
-void ColorCyclingApplication::reshape(int x, int y) const {
-  int loc;
-  float aspect = (float) x / (float) y;
-  float fbaspect = (float) fbwidth / (float) fbheight;
-  float xform[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
-
-  glViewport(0, 0, x, y);
-
-  if (aspect > fbaspect) {
-    xform[0] = fbaspect / aspect;
-  } else if (fbaspect > aspect) {
-    xform[5] = aspect / fbaspect;
-  }
-
-  glUseProgram(m_shaderProgram);
-  if ((loc = glGetUniformLocation(m_shaderProgram, "xform")) >= 0) {
-    glUniformMatrix4fv(loc, 1, GL_FALSE, xform);
-  }
 
-  auto err = glGetError();
-  assert(err == GL_NO_ERROR);
+  // the palette is uploaded once per rendered frame, even when several updates ran, and only when a step changed it
+  if (m_cycler.step(*m_image))
+    m_paletteChanged = true;
 }
 
 void ColorCyclingApplication::onImGuiRender() {
   if (ImGui::BeginMainMenuBar()) {
     if (ImGui::BeginMenu("File")) {
       if (ImGui::MenuItem("Open", "Ctrl+O")) {
-        // open Dialog Simple
-        igfd::ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey", "Choose File", ".LBM", ".");
+        // with the thumbnails of the directory on the side
+        m_listedDirectory.clear();
+        igfd::ImGuiFileDialog::Instance()->OpenDialog(
+            "ChooseFileDlgKey", "Choose File", "Images{.LBM,.ANM,.ANIM,.ccyc}", ".", "",
+            [this](const std::string &, igfd::UserDatas, bool *) { drawThumbnails(); }, ThumbnailPaneWidth);
       }
       ImGui::Separator();
       if (ImGui::MenuItem("Quit", "Ctrl+Q")) {
@@ -431,8 +384,11 @@ void ColorCyclingApplication::onImGuiRender() {
       ImGui::MenuItem("Debug", "Ctrl+I", &m_showInfo, (bool) m_image);
       ImGui::EndMenu();
     }
+    if (m_loader.getNumPending() > 0) {
+      ImGui::Text("Loading %zu file(s)...", m_loader.getNumPending());
+    }
     char fps[128];
-    sprintf(fps, "%.2f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    sprintf(fps, "%.2f ms/frame (%.1f FPS, %.1f measured)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate, m_fps);
     auto size = ImGui::CalcTextSize(fps);
     ImGui::SetCursorPosX(ImGui::GetWindowContentRegionMax().x - size.x);
     ImGui::Text("%s", fps);
@@ -443,11 +399,17 @@ void ColorCyclingApplication::onImGuiRender() {
   if (igfd::ImGuiFileDialog::Instance()->FileDialog("ChooseFileDlgKey")) {
     if (igfd::ImGuiFileDialog::Instance()->IsOk) {
       auto filePathName = igfd::ImGuiFileDialog::Instance()->GetFilepathName();
-      loadLbm(filePathName);
+      m_loader.load(filePathName);
     }
     // close
     igfd::ImGuiFileDialog::Instance()->CloseDialog("ChooseFileDlgKey");
   }
+  if (!m_thumbnailChoice.empty()) {
+    m_loader.load(m_thumbnailChoice);
+    m_thumbnailChoice.clear();
+    igfd::ImGuiFileDialog::Instance()->CloseDialog("ChooseFileDlgKey");
+  }
+  m_thumbnailTextures.collect();
 
   if (!m_image)
     return;
@@ -462,28 +424,55 @@ void ColorCyclingApplication::onImGuiRender() {
         ImGui::Text("Mask: %s", masks[std::clamp((int) image.header.masking, 0, 2)]);
         const char *compressions[] = {"uncompressed", "RLE", "vertical RLE"};
         ImGui::Text("Compression: %s", compressions[std::clamp((int) image.header.compression, 0, 2)]);
+        ImGui::Text("Display: %s", image.isHam() ? (image.header.num_planes == 6 ? "HAM6" : "HAM8") : image.isExtraHalfBrite() ? "Extra-Half-Brite" : "normal");
+        if (m_anim)
+          ImGui::Text("ANIM frame %zu / %zu", m_anim->getFrame() + 1, m_anim->getNumFrames());
         ImGui::Text("Pixel aspect: %d:%d", image.header.x_aspect, image.header.y_aspect);
         ImGui::Text("Page Size %dx%d", image.header.page_width, image.header.page_width);
         ImGui::TreePop();
       }
 
       if (ImGui::TreeNode("Options")) {
-        ImGui::Checkbox("Cycle Blend", &m_blend);
-        ImGui::DragFloat("Cycle Speed", &m_speed, 0.25f, 0.25f, 4.f);
+        auto blend = m_cycler.getBlend();
+        if (ImGui::Checkbox("Cycle Blend", &blend)) {
+          m_cycler.setBlend(blend);
+        }
+        auto speed = m_cycler.getSpeed();
+        if (ImGui::DragFloat("Cycle Speed", &speed, 0.25f, 0.25f, 4.f)) {
+          m_cycler.setSpeed(speed);
+        }
+        ImGui::TreePop();
+      }
+
+      if (ImGui::TreeNode("Cache")) {
+        const auto stats = m_cache.getStats();
+        ImGui::Text("%zu images, %.1f / %.1f MB", m_cache.getNumScenes(), static_cast<double>(m_cache.getSize()) / (1 << 20),
+                    static_cast<double>(m_cache.getBudget()) / (1 << 20));
+        ImGui::Text("%zu hits, %zu shared bodies, %zu decoded", stats.numHits, stats.numBodyHits, stats.numMisses);
+        ImGui::TreePop();
+      }
+
+      if (ImGui::TreeNode("Timings")) {
+        drawTimings(m_profiler);
+        if (ImGui::Button("Save CSV")) {
+          saveTimings(TimingsPath);
+        }
         ImGui::TreePop();
       }
 
       // draw palette
       if (ImGui::TreeNode("Palette")) {
         auto index = drawPalette(m_image->palette.data());
-        if (m_currentColorIndex != -1) {
-          memcpy(m_image->palette.data() + m_currentColorIndex * 3, m_palette.data() + m_currentColorIndex * 3, 3);
+        auto currentColorIndex = m_cycler.getLockedIndex();
+        if (currentColorIndex != -1) {
+          memcpy(m_image->palette.data() + currentColorIndex * 3, m_cycler.getBasePalette().data() + currentColorIndex * 3, 3);
         }
         if (index != -1) {
           ImGui::Text("Color #%d", index);
-          m_currentColorIndex = index;
-          memset(m_image->palette.data() + m_currentColorIndex * 3, 255, 3);
+          m_cycler.setLockedIndex(index);
+          memset(m_image->palette.data() + index * 3, 255, 3);
         }
+        m_paletteChanged |= currentColorIndex != -1 || index != -1;
         ImGui::TreePop();
       }
     }
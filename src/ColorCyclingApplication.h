@@ -3,14 +3,28 @@
 
 #include <array>
 #include <memory>
+#include <string>
+#include "Anim.h"
 #include "Application.h"
+#include "AsyncLoader.h"
+#include "ColorCycler.h"
 #include "Ilbm.h"
+#include "IlbmLoader.h"
+#include "Renderer.h"
+#include "SceneCache.h"
+#include "ThumbnailTextures.h"
+#include "Thumbnails.h"
+#include <vector>
 
 class ColorCyclingApplication final : public Application {
 public:
-  explicit ColorCyclingApplication();
+  /* path is an optional image loaded at startup */
+  explicit ColorCyclingApplication(std::string path = {});
   ~ColorCyclingApplication() override;
 
+  /* bytes of decoded images kept to switch back to them without decoding */
+  void setCacheBudget(std::size_t budget) { m_cache.setBudget(budget); }
+
 protected:
   void onInit() override;
   void onImGuiRender() override;
@@ -19,22 +33,52 @@ protected:
   void onUpdate(const TimeSpan& elapsed) override;
 
 private:
-  void reshape(int x, int y) const;
-  void loadLbm(const std::string &path);
-  void setPalette(Ilbm &img, int idx, std::uint8_t r, std::uint8_t g, std::uint8_t b) const;
+  /* loads an image synchronously, for the benchmarks */
+  bool loadLbm(const std::string &path);
+  /* swaps in the images loaded in the background, only the last one when several are ready. The rows of
+   * the image loading first are uploaded as they are decoded. */
+  void updateLoads();
+  /* uploads the decoded rows of m_streamed not uploaded yet, within UploadBudget */
+  void uploadStreamedRows();
+  /* replaces the displayed image and uploads it */
+  void setImage(std::unique_ptr<Ilbm> image);
+  /* plays the frames after the first one of path, the displayed image, when it is an ANIM */
+  void openAnim(const std::string &path);
+  /* the options pane of the file dialog: the thumbnails of the images of its directory */
+  void drawThumbnails();
+  /* draws the thumbnail of path centered in a size x size button, true when it is clicked */
+  bool drawThumbnail(const std::string &path, float size);
+  /* lists the .lbm, .anm/.anim and .ccyc files of directory into m_listedImages */
+  void listImages(const std::string &directory);
+  /* writes the frame timings history */
+  void saveTimings(const std::string &path) const;
 
 private:
+  std::string m_initialPath;
   std::unique_ptr<Ilbm> m_image{};
-  std::array<std::uint8_t, 256*3> m_palette{};
-  int m_shaderProgram{0};
-  unsigned int m_vao{0};
-  unsigned int m_vbo{0}, m_ebo{0};
-  unsigned int m_img_tex{0}, m_pal_tex{0};
-  float time_msec{0};
+  SceneCache m_cache;
+  AsyncLoader m_loader{&m_cache};
+  /* the load whose rows are being uploaded, until all of them are */
+  std::shared_ptr<const IlbmLoader::Progress> m_streamed;
+  int m_uploadedRows{0};
+  /* m_streamed is displayed while m_image is still the previous image */
+  bool m_previewing{false};
+  ColorCycler m_cycler;
+  /* the frames of m_image, null for a still image */
+  std::unique_ptr<Anim> m_anim;
+  int m_animTicks{0};
+  /* the part of m_image changed by the frames since the last upload */
+  Anim::Rect m_animChanged;
+  Renderer m_renderer;
+  bool m_paletteChanged{false};
   bool m_showInfo{true};
-  bool m_blend{true};
-  float m_speed{1.f};
-  int m_currentColorIndex{-1};
+  Thumbnails m_thumbnails;
+  ThumbnailTextures m_thumbnailTextures;
+  bool m_animateThumbnails{true};
+  std::string m_listedDirectory;
+  std::vector<std::string> m_listedImages;
+  /* the image clicked in the thumbnails, opened once the dialog is drawn */
+  std::string m_thumbnailChoice;
 };
 
 #endif//COLORCYCLING__COLORCYCLINGAPPLICATION_H
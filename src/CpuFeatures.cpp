@@ -0,0 +1,72 @@
+#include "CpuFeatures.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define COLORCYCLING_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+#ifdef COLORCYCLING_X86
+void cpuid(int leaf, int subLeaf, std::uint32_t regs[4]) {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuidex(info, leaf, subLeaf);
+  for (auto i = 0; i < 4; i++)
+    regs[i] = static_cast<std::uint32_t>(info[i]);
+#else
+  __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+std::uint64_t xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  std::uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures detect() {
+  CpuFeatures features;
+  std::uint32_t regs[4];
+  cpuid(0, 0, regs);
+  const auto maxLeaf = regs[0];
+  if (maxLeaf < 1)
+    return features;
+
+  cpuid(1, 0, regs);
+  features.sse41 = (regs[2] & (1u << 19)) != 0;
+  const auto osxsave = (regs[2] & (1u << 27)) != 0;
+  if (!osxsave || maxLeaf < 7)
+    return features;
+
+  // the OS has to save the YMM (and for AVX-512 the opmask and ZMM) registers on context switches
+  const auto xcr0 = xgetbv();
+  const auto avxState = (xcr0 & 0x6) == 0x6;
+  const auto avx512State = (xcr0 & 0xe6) == 0xe6;
+
+  cpuid(7, 0, regs);
+  features.avx2 = avxState && (regs[1] & (1u << 5)) != 0;
+  const auto avx512f = avx512State && (regs[1] & (1u << 16)) != 0;
+  features.avx512bw = avx512f && (regs[1] & (1u << 30)) != 0;
+  features.avx512vbmi = features.avx512bw && (regs[2] & (1u << 1)) != 0;
+  return features;
+}
+#else
+CpuFeatures detect() {
+  return {};
+}
+#endif
+}// namespace
+
+const CpuFeatures &CpuFeatures::get() {
+  static const CpuFeatures features = detect();
+  return features;
+}
@@ -0,0 +1,14 @@
+#ifndef COLORCYCLING__CPUFEATURES_H
+#define COLORCYCLING__CPUFEATURES_H
+
+/* instruction set extensions usable on this CPU, i.e. supported by the CPU and enabled by the OS */
+struct CpuFeatures {
+  bool sse41{false};
+  bool avx2{false};
+  bool avx512bw{false};
+  bool avx512vbmi{false};
+
+  static const CpuFeatures &get();
+};
+
+#endif//COLORCYCLING__CPUFEATURES_H
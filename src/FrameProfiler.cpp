@@ -0,0 +1,77 @@
+#include "FrameProfiler.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+void printRow(std::ostream &out, const char *name, const std::vector<double> &samples) {
+  auto summary = Statistics::summarize(samples);
+  char row[128];
+  std::snprintf(row, sizeof(row), "%-12s %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+  out << row;
+}
+}// namespace
+
+FrameProfiler::FrameProfiler() : m_history(HistorySize) {}
+
+const char *FrameProfiler::getPhaseName(Phase phase) {
+  switch (phase) {
+  case Phase::Events: return "events";
+  case Phase::Update: return "update";
+  case Phase::Upload: return "upload";
+  case Phase::Draw: return "draw";
+  case Phase::ImGuiBuild: return "imgui_build";
+  case Phase::ImGuiRender: return "imgui_render";
+  case Phase::Swap: return "swap";
+  }
+  return "?";
+}
+
+void FrameProfiler::beginFrame() {
+  m_current = Frame();
+  m_frameStart = Clock::now();
+}
+
+void FrameProfiler::endFrame() {
+  m_current.total = std::chrono::duration<double, std::milli>(Clock::now() - m_frameStart).count();
+  if (m_recording)
+    m_frames.push_back(m_current);
+  m_history[m_historyNext] = m_current;
+  m_historyNext = (m_historyNext + 1) % HistorySize;
+  m_historySize = std::min(m_historySize + 1, HistorySize);
+}
+
+void FrameProfiler::printSummary(std::ostream &out) const {
+  if (m_frames.empty())
+    return;
+  char header[128];
+  std::snprintf(header, sizeof(header), "%-12s %9s %9s %9s %9s %9s\n", "phase (ms)", "mean", "p50", "p95", "p99", "max");
+  out << header;
+  std::vector<double> samples(m_frames.size());
+  for (auto i = 0; i < NumPhases; i++) {
+    for (std::size_t frame = 0; frame < m_frames.size(); frame++) {
+      samples[frame] = m_frames[frame].phases[i];
+    }
+    printRow(out, getPhaseName(static_cast<Phase>(i)), samples);
+  }
+  for (std::size_t frame = 0; frame < m_frames.size(); frame++) {
+    samples[frame] = m_frames[frame].total;
+  }
+  printRow(out, "frame", samples);
+}
+
+void FrameProfiler::writeCsv(std::ostream &out) const {
+  out << "frame";
+  for (auto i = 0; i < NumPhases; i++) {
+    out << ',' << getPhaseName(static_cast<Phase>(i)) << "_ms";
+  }
+  out << ",total_ms,updates\n";
+  for (std::size_t index = 0; index < m_historySize; index++) {
+    const auto &frame = getHistoryFrame(index);
+    out << index;
+    for (auto ms : frame.phases) {
+      out << ',' << ms;
+    }
+    out << ',' << frame.total << ',' << frame.counts[static_cast<int>(Phase::Update)] << '\n';
+  }
+}
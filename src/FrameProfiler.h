@@ -0,0 +1,78 @@
+#ifndef COLORCYCLING__FRAMEPROFILER_H
+#define COLORCYCLING__FRAMEPROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+/* wall time spent by each phase of the frames of the application */
+class FrameProfiler {
+  using Clock = std::chrono::steady_clock;
+
+public:
+  enum class Phase { Events, Update, Upload, Draw, ImGuiBuild, ImGuiRender, Swap };
+  static constexpr int NumPhases = 7;
+  /* number of frames kept in the history */
+  static constexpr std::size_t HistorySize = 512;
+
+  /* times a phase until the end of the scope, a phase may be timed several times in a frame */
+  class Scope {
+  public:
+    Scope(FrameProfiler &profiler, Phase phase) : m_profiler(profiler), m_phase(phase), m_start(Clock::now()) {}
+    ~Scope() { m_profiler.add(m_phase, std::chrono::duration<double, std::milli>(Clock::now() - m_start).count()); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    FrameProfiler &m_profiler;
+    Phase m_phase;
+    Clock::time_point m_start;
+  };
+
+  /* phase durations of a frame in milliseconds */
+  struct Frame {
+    std::array<double, NumPhases> phases{};
+    std::array<int, NumPhases> counts{}; /* number of times each phase ran, the updates per frame for example */
+    double total{0};
+  };
+
+public:
+  FrameProfiler();
+
+  static const char *getPhaseName(Phase phase);
+
+  /* keeps every frame for summarize, for the benchmark mode */
+  void setRecording(bool recording) { m_recording = recording; }
+  void beginFrame();
+  void endFrame();
+  void add(Phase phase, double ms) {
+    m_current.phases[static_cast<int>(phase)] += ms;
+    m_current.counts[static_cast<int>(phase)]++;
+  }
+
+  [[nodiscard]] const std::vector<Frame> &getFrames() const { return m_frames; }
+  /* prints the distribution of the recorded frames, phase by phase */
+  void printSummary(std::ostream &out) const;
+
+  /* the last frames, index 0 is the oldest */
+  [[nodiscard]] std::size_t getHistorySize() const { return m_historySize; }
+  [[nodiscard]] const Frame &getHistoryFrame(std::size_t index) const {
+    return m_history[(m_historyNext + HistorySize - m_historySize + index) % HistorySize];
+  }
+  /* writes the history as CSV, one line per frame */
+  void writeCsv(std::ostream &out) const;
+
+private:
+  Frame m_current;
+  Clock::time_point m_frameStart;
+  std::vector<Frame> m_frames;
+  bool m_recording{false};
+  std::vector<Frame> m_history;
+  std::size_t m_historyNext{0};
+  std::size_t m_historySize{0};
+};
+
+#endif//COLORCYCLING__FRAMEPROFILER_H
@@ -0,0 +1,58 @@
+#include "IffReader.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+constexpr std::size_t HeaderSize = 8;
+}
+
+bool IffChunk::is(const char *chunkId) const {
+  return std::memcmp(id, chunkId, 4) == 0;
+}
+
+IffReader::IffReader(Span<const std::uint8_t> data) {
+  if (data.size() < HeaderSize + 4 || std::memcmp(data.data(), "FORM", 4) != 0)
+    throw std::runtime_error("Error when reading the IFF header: not a FORM");
+  // the form type is part of the FORM, whose chunks must all be in the data
+  const auto length = readU32(data, 4);
+  if (length < 4)
+    throw std::runtime_error("Error when reading the IFF header: the FORM is too short for its type");
+  // some writers count the pad byte of an odd last chunk without writing it, next() checks the chunk is odd
+  m_padMissing = length == data.size() - HeaderSize + 1;
+  if (length > data.size() - HeaderSize && !m_padMissing) {
+    std::ostringstream ss;
+    ss << "Error when reading the IFF header: " << length << " bytes announced, " << data.size() - HeaderSize
+       << " left in the file";
+    throw std::runtime_error(ss.str());
+  }
+  m_form = data.subspan(HeaderSize, length - (m_padMissing ? 1 : 0));
+  std::memcpy(m_formType, m_form.data(), 4);
+  m_offset = 4;
+}
+
+bool IffReader::next(IffChunk &chunk) {
+  // a few bytes after the last chunk are padding
+  if (m_offset > m_form.size() || m_form.size() - m_offset < HeaderSize) {
+    if (m_padMissing && !m_padOfLastChunk)
+      throw std::runtime_error("Error when reading the IFF header: the FORM runs 1 byte past the end of the file");
+    return false;
+  }
+
+  const auto length = readU32(m_form, m_offset + 4);
+  const auto dataOffset = m_offset + HeaderSize;
+  if (length > m_form.size() - dataOffset) {
+    std::ostringstream ss;
+    ss << "Error when reading the chunk " << std::string(reinterpret_cast<const char *>(m_form.data() + m_offset), 4) << ": "
+       << length << " bytes announced, " << m_form.size() - dataOffset << " left in the file";
+    throw std::runtime_error(ss.str());
+  }
+  std::memcpy(chunk.id, m_form.data() + m_offset, 4);
+  chunk.data = m_form.subspan(dataOffset, length);
+  // chunks are aligned on even offsets
+  m_offset = dataOffset + length + (length & 1);
+  m_padOfLastChunk = m_offset == m_form.size() + 1;
+  if (m_offset > m_form.size())
+    m_offset = m_form.size();
+  return true;
+}
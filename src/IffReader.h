@@ -0,0 +1,49 @@
+#ifndef COLORCYCLING__IFFREADER_H
+#define COLORCYCLING__IFFREADER_H
+
+#include "Span.h"
+#include <cstdint>
+#include <string>
+
+/* a chunk of an IFF file, its data points into the file */
+struct IffChunk {
+  char id[4]{};
+  Span<const std::uint8_t> data;
+
+  [[nodiscard]] bool is(const char *chunkId) const;
+};
+
+/* Iterates over the chunks of an in-memory IFF FORM (PBM, ILBM...) without copying them.
+ * Every chunk is checked against the end of the FORM, a chunk running past it throws std::runtime_error. The
+ * FORM may count the pad byte of an odd last chunk missing at the end of the file. */
+class IffReader {
+public:
+  /* throws std::runtime_error when data doesn't start with a FORM header */
+  explicit IffReader(Span<const std::uint8_t> data);
+
+  /* the form type, "PBM " or "ILBM" for example */
+  [[nodiscard]] std::string getFormType() const { return std::string(m_formType, 4); }
+
+  /* reads the next chunk, returns false at the end of the FORM */
+  bool next(IffChunk &chunk);
+
+private:
+  Span<const std::uint8_t> m_form;
+  std::size_t m_offset{0};
+  char m_formType[4]{};
+  /* the FORM counts 1 byte more than the file, allowed when it is the pad byte of its last chunk */
+  bool m_padMissing{false};
+  bool m_padOfLastChunk{false};
+};
+
+/* big-endian integer at data[offset], the caller checks the bounds */
+inline std::uint16_t readU16(Span<const std::uint8_t> data, std::size_t offset) {
+  return static_cast<std::uint16_t>(data[offset] << 8 | data[offset + 1]);
+}
+
+inline std::uint32_t readU32(Span<const std::uint8_t> data, std::size_t offset) {
+  return static_cast<std::uint32_t>(data[offset]) << 24 | static_cast<std::uint32_t>(data[offset + 1]) << 16 |
+         static_cast<std::uint32_t>(data[offset + 2]) << 8 | data[offset + 3];
+}
+
+#endif//COLORCYCLING__IFFREADER_H
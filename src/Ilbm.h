@@ -1,8 +1,10 @@
 #ifndef COLORCYCLING__ILBM_H
 #define COLORCYCLING__ILBM_H
 
+#include "Span.h"
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 struct Chunk {
@@ -30,12 +32,44 @@ struct Crng {
   std::uint8_t high{0};    /* The index of the last entry in the colour map that is part of this range.*/
 };
 
+/* CAMG viewport mode bits */
+constexpr std::uint32_t CamgExtraHalfBrite = 0x80; /* colors 32 to 63 are colors 0 to 31 at half brightness */
+constexpr std::uint32_t CamgHam = 0x800;           /* hold-and-modify */
+
 struct Ilbm {
   BitmapHeader header;
   std::vector<std::uint8_t> image;
   std::array<std::uint8_t, 256 * 3> palette;
   std::array<Crng, 256> cycles;
   std::uint8_t numCycles{0};
+  /* color indices read straight from the file (uncompressed BODY) instead of image, storage keeps them alive */
+  Span<const std::uint8_t> mappedImage;
+  std::shared_ptr<const void> storage;
+  /* RGB pixels of the 24-bit deep images, which have no color indices, or the colors resolved from the
+   * indices of the HAM images: 3 * stride() bytes per row */
+  std::vector<std::uint8_t> rgb;
+  /* the CAMG viewport mode, 0 without CAMG */
+  std::uint32_t viewMode{0};
+  /* the palettes of the first cycling ticks baked in a .ccyc scene (see SceneFile.h), 256 RGB colors each, cycled
+   * at speed 1 with or without blend, a view that storage keeps alive */
+  Span<const std::uint8_t> bakedPalettes;
+  bool bakedBlend{true};
+
+  /* bytes per row of pixels(), rows are stored with an even width */
+  [[nodiscard]] std::size_t stride() const { return (header.width + 1u) & ~1u; }
+
+  /* true for the deep and the HAM images, drawn from rgb instead of through the palette */
+  [[nodiscard]] bool isTrueColor() const { return !rgb.empty(); }
+
+  /* HAM6 or HAM8: the 2 upper bits of an index modify a component of the color of the previous pixel */
+  [[nodiscard]] bool isHam() const { return (viewMode & CamgHam) && (header.num_planes == 6 || header.num_planes == 8); }
+
+  [[nodiscard]] bool isExtraHalfBrite() const { return (viewMode & CamgExtraHalfBrite) && !isHam(); }
+
+  /* the color indices, stride() bytes per row */
+  [[nodiscard]] Span<const std::uint8_t> pixels() const {
+    return mappedImage.empty() ? Span<const std::uint8_t>(image.data(), image.size()) : mappedImage;
+  }
 };
 
 #endif//COLORCYCLING__ILBM_H
@@ -0,0 +1,416 @@
+#include "IlbmLoader.h"
+#include "ByteRun1.h"
+#include "IffReader.h"
+#include "MappedFile.h"
+#include "Planar.h"
+#include "SceneFile.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "VerticalRle.h"
+#include "ViewModes.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <sstream>
+
+namespace IlbmLoader {
+namespace {
+/* images from this number of pixels get their rows decoded in parallel */
+constexpr std::size_t ParallelDecodeThreshold = 1u << 20;
+/* number of pixels decoded by a task */
+constexpr std::size_t ParallelDecodeGrain = 1u << 16;
+/* number of pixels decoded before the rows are published to a progress */
+constexpr std::size_t ProgressStripe = 1u << 18;
+/* planes of the deep images, 8 per RGB component */
+constexpr int MaxPlanes = 24;
+/* BMHD masking value of the bodies with a mask plane after the color planes */
+constexpr std::uint8_t MaskHasMask = 1;
+/* BMHD compression values */
+constexpr std::uint8_t CompressionByteRun1 = 1;
+constexpr std::uint8_t CompressionVerticalRle = 2;
+
+void readHeader(Span<const std::uint8_t> data, BitmapHeader &header) {
+  if (data.size() < 20)
+    throw std::runtime_error("Error when reading the BMHD chunk: too short");
+  header.width = readU16(data, 0);
+  header.height = readU16(data, 2);
+  header.x = static_cast<short>(readU16(data, 4));
+  header.y = static_cast<short>(readU16(data, 6));
+  header.num_planes = data[8];
+  header.masking = data[9];
+  header.compression = data[10];
+  header.pad1 = data[11];
+  header.transparent_color = readU16(data, 12);
+  header.x_aspect = data[14];
+  header.y_aspect = data[15];
+  header.page_width = static_cast<short>(readU16(data, 16));
+  header.page_height = static_cast<short>(readU16(data, 18));
+}
+
+void readCycle(Span<const std::uint8_t> data, Crng &cycle) {
+  if (data.size() < 8)
+    throw std::runtime_error("Error when reading the CRNG chunk: too short");
+  cycle.padding = static_cast<std::int16_t>(readU16(data, 0));
+  cycle.rate = static_cast<std::int16_t>(readU16(data, 2));
+  cycle.flags = static_cast<std::int16_t>(readU16(data, 4));
+  cycle.low = data[6];
+  cycle.high = data[7];
+}
+
+using RowsCallback = std::function<void(std::size_t begin, std::size_t end)>;
+
+/* makes the image visible to the progress once its pixels are allocated */
+void start(Progress *progress, const Ilbm &image) {
+  if (!progress || progress->started.load(std::memory_order_relaxed))
+    return;
+  progress->header = image.header;
+  progress->palette = image.palette;
+  progress->trueColor = image.isTrueColor();
+  progress->stride = image.stride();
+  progress->pixels = progress->trueColor ? image.rgb.data() : image.pixels().data();
+  progress->started.store(true, std::memory_order_release);
+}
+
+void publishRows(Progress *progress, std::size_t numRows) {
+  if (progress)
+    progress->numRows.store(numRows, std::memory_order_release);
+}
+
+/* ByteRun1 runs never cross a row, the rows of large images are decoded in parallel, straight into out.
+ * onRows(begin, end) is called once the rows are decoded, for stripes of rows from the top when inStripes. */
+void decodeRows(Span<const std::uint8_t> body, std::size_t rowSize, std::size_t numRows, std::uint8_t *out, bool inStripes, const RowsCallback &onRows) {
+  auto &pool = ThreadPool::getShared();
+  const auto parallel = rowSize * numRows >= ParallelDecodeThreshold && pool.getNumThreads() > 0;
+  std::vector<std::size_t> offsets;
+  if (!(parallel || inStripes) || !ByteRun1::findRows(body, rowSize, numRows, offsets)) {
+    ByteRun1::decode(body, out, rowSize * numRows);
+    onRows(0, numRows);
+    return;
+  }
+
+  const auto decode = [&](std::size_t begin, std::size_t end) {
+    for (auto row = begin; row < end; row++) {
+      ByteRun1::decode(body.subspan(offsets[row], offsets[row + 1] - offsets[row]), out + row * rowSize, rowSize);
+    }
+  };
+  const auto stripeRows = inStripes ? std::max<std::size_t>(1, ProgressStripe / rowSize) : numRows;
+  for (std::size_t first = 0; first < numRows; first += stripeRows) {
+    const auto last = std::min(numRows, first + stripeRows);
+    if (parallel) {
+      pool.parallelFor(last - first, std::max<std::size_t>(1, ParallelDecodeGrain / rowSize), [&](std::size_t begin, std::size_t end) {
+        TRACE_SCOPE("BODY rows");
+        decode(first + begin, first + end);
+      });
+    } else {
+      decode(first, last);
+    }
+    onRows(first, last);
+  }
+}
+
+/* where the plane lines are in a planar body: line p of row y starts at y * rowStep + p * planeStep */
+struct PlanarLayout {
+  std::size_t lineSize;
+  std::size_t rowStep;
+  std::size_t planeStep;
+};
+
+/* interleaved ILBM rows: one line per plane followed by the mask line, which is skipped */
+PlanarLayout getInterleavedLayout(const BitmapHeader &header) {
+  const auto lineSize = Planar::getLineSize(header.width);
+  const auto numLines = header.num_planes + (header.masking == MaskHasMask ? 1u : 0u);
+  return {lineSize, lineSize * numLines, lineSize};
+}
+
+/* ACBM planes are stored one after the other */
+PlanarLayout getContiguousLayout(const BitmapHeader &header) {
+  const auto lineSize = Planar::getLineSize(header.width);
+  return {lineSize, lineSize, lineSize * header.height};
+}
+
+/* converts the planes of rows [first, last) into color indices, or into RGB pixels for the 24 planes of deep images */
+void convertPlanes(const std::uint8_t *planar, const PlanarLayout &layout, std::size_t first, std::size_t last, Ilbm &image) {
+  const auto &header = image.header;
+  const auto stride = image.stride();
+  const auto numPlanes = header.num_planes;
+  std::optional<ViewModes::HamResolver> ham;
+  if (image.isHam())
+    ham.emplace(numPlanes, image.palette.data());
+  const auto convertRows = [&](std::size_t begin, std::size_t end) {
+    const std::uint8_t *planes[MaxPlanes];
+    for (auto y = begin; y < end; y++) {
+      for (auto p = 0; p < numPlanes; p++) {
+        planes[p] = planar + y * layout.rowStep + p * layout.planeStep;
+      }
+      if (numPlanes == MaxPlanes) {
+        Planar::toRgb(planes, header.width, image.rgb.data() + y * stride * 3);
+      } else {
+        Planar::toChunky(planes, numPlanes, header.width, image.image.data() + y * stride);
+      }
+      if (ham)
+        ham->resolveRow(image.image.data() + y * stride, header.width, image.rgb.data() + y * stride * 3);
+    }
+  };
+
+  auto &pool = ThreadPool::getShared();
+  const auto numPixels = stride * (last - first);
+  if (numPixels < ParallelDecodeThreshold || pool.getNumThreads() == 0) {
+    convertRows(first, last);
+    return;
+  }
+  pool.parallelFor(last - first, std::max<std::size_t>(1, ParallelDecodeGrain / stride), [&](std::size_t begin, std::size_t end) {
+    TRACE_SCOPE("planar rows");
+    convertRows(first + begin, first + end);
+  });
+}
+
+/* checks the number of planes and allocates the pixels they are converted into */
+void preparePlanarImage(Ilbm &image) {
+  const auto &header = image.header;
+  if (header.num_planes == 0 || (header.num_planes > 8 && header.num_planes != MaxPlanes)) {
+    std::ostringstream ss;
+    ss << "Error when reading the body: " << static_cast<int>(header.num_planes) << " bitplanes are not supported";
+    throw std::runtime_error(ss.str());
+  }
+
+  const auto size = image.stride() * header.height;
+  if (header.num_planes == MaxPlanes) {
+    image.rgb.assign(size * 3, 0);
+  } else {
+    image.image.assign(size, 0);
+  }
+  // the HAM rows are resolved as they are converted, the image is drawn from its colors
+  if (image.isHam())
+    image.rgb.assign(size * 3, 0);
+}
+
+/* decodes a BODY of interleaved planes (ILBM) or an ABIT chunk of contiguous planes (ACBM) */
+void readPlanarBody(Span<const std::uint8_t> body, const PlanarLayout &layout, bool compressed, Ilbm &image, Progress *progress) {
+  const auto &header = image.header;
+  preparePlanarImage(image);
+  start(progress, image);
+  // the last row only needs its plane lines
+  const auto planarSize = header.height == 0 ? 0 : (header.height - 1) * layout.rowStep + (header.num_planes - 1) * layout.planeStep + layout.lineSize;
+  if (!compressed && body.size() >= planarSize) {
+    convertPlanes(body.data(), layout, 0, header.height, image);
+    return;
+  }
+  std::vector<std::uint8_t> planar(std::max(planarSize, layout.rowStep * header.height));
+  if (compressed) {
+    // each stripe is converted as soon as it is decoded
+    decodeRows(body, layout.rowStep, header.height, planar.data(), progress != nullptr, [&](std::size_t begin, std::size_t end) {
+      convertPlanes(planar.data(), layout, begin, end, image);
+      publishRows(progress, end);
+    });
+  } else {
+    std::copy_n(body.data(), std::min(planar.size(), body.size()), planar.data());
+    convertPlanes(planar.data(), layout, 0, header.height, image);
+  }
+}
+
+/* decodes a vertical RLE BODY: one VDAT chunk per plane, the planes are decoded in parallel */
+void readVerticalRleBody(Span<const std::uint8_t> body, Ilbm &image, Progress *progress) {
+  const auto &header = image.header;
+  preparePlanarImage(image);
+  start(progress, image);
+  std::vector<Span<const std::uint8_t>> vdats;
+  std::size_t offset = 0;
+  while (vdats.size() < header.num_planes && offset + 8 <= body.size()) {
+    const auto size = readU32(body, offset + 4);
+    if (std::memcmp(body.data() + offset, "VDAT", 4) == 0)
+      vdats.push_back(body.subspan(offset + 8, size));
+    offset += 8 + std::min<std::size_t>(size + (size & 1), body.size() - offset - 8);
+  }
+
+  // decoded like an ACBM body, the planes one after the other
+  const auto layout = getContiguousLayout(header);
+  std::vector<std::uint8_t> planar(layout.planeStep * header.num_planes);
+  const auto decodePlanes = [&](std::size_t begin, std::size_t end) {
+    for (auto p = begin; p < end; p++) {
+      VerticalRle::decodePlane(vdats[p], layout.lineSize, header.height, planar.data() + p * layout.planeStep);
+    }
+  };
+  auto &pool = ThreadPool::getShared();
+  if (planar.size() < ParallelDecodeThreshold || pool.getNumThreads() == 0) {
+    decodePlanes(0, vdats.size());
+  } else {
+    pool.parallelFor(vdats.size(), 1, [&](std::size_t begin, std::size_t end) {
+      TRACE_SCOPE("VDAT");
+      decodePlanes(begin, end);
+    });
+  }
+  convertPlanes(planar.data(), layout, 0, header.height, image);
+}
+
+/* an uncompressed chunky body becomes a view of file when there is one, instead of a copy */
+void readBody(Span<const std::uint8_t> body, bool isChunky, const std::shared_ptr<const MappedFile> &file, Ilbm &image, Progress *progress) {
+  const auto size = image.stride() * image.header.height;
+  const auto compression = image.header.compression;
+  if (compression > CompressionVerticalRle || (isChunky && compression == CompressionVerticalRle)) {
+    std::ostringstream ss;
+    ss << "Error when reading the BODY chunk: compression " << static_cast<int>(compression) << " is not supported";
+    throw std::runtime_error(ss.str());
+  }
+  if (!isChunky && compression == CompressionVerticalRle) {
+    readVerticalRleBody(body, image, progress);
+  } else if (!isChunky) {
+    readPlanarBody(body, getInterleavedLayout(image.header), compression == CompressionByteRun1, image, progress);
+  } else if (compression == CompressionByteRun1) {
+    image.image.resize(size);
+    start(progress, image);
+    decodeRows(body, image.stride(), image.header.height, image.image.data(), progress != nullptr, [&](std::size_t, std::size_t end) {
+      publishRows(progress, end);
+    });
+  } else if (file && body.size() >= size) {
+    // PBM rows are stored with an even width like the decoded ones
+    image.mappedImage = body.subspan(0, size);
+    image.storage = file;
+  } else {
+    image.image.assign(size, 0);
+    std::copy_n(body.data(), std::min(size, body.size()), image.image.data());
+  }
+  start(progress, image);
+  publishRows(progress, image.header.height);
+}
+
+/* the palette of an Extra-Half-Brite image gets its darker half. The chunky bodies are never HAM. */
+void prepareViewMode(bool isChunky, Ilbm &image) {
+  if (isChunky)
+    image.viewMode &= ~CamgHam;
+  if (image.isExtraHalfBrite())
+    ViewModes::extendHalfBrite(image.palette);
+}
+
+/* the parts of a file parse reads */
+enum class Part {
+  Image,     /* everything */
+  Chunks,    /* everything but the body */
+  Thumbnail, /* the TINY chunk instead of the body */
+};
+
+/* Only the first body is read, the pixels never move once they are published to progress */
+void parse(Span<const std::uint8_t> data, const std::shared_ptr<const MappedFile> &file, Ilbm &image, Progress *progress, Part part) {
+  if (SceneFile::isSceneFile(data)) {
+    TRACE_SCOPE("SceneFile");
+    // already decoded, the indices are used where they are mapped
+    SceneFile::toIlbm(SceneFile::parse(data), file, image);
+    if (!file) {
+      image.image.assign(image.mappedImage.begin(), image.mappedImage.end());
+      image.mappedImage = {};
+      image.bakedPalettes = {};
+    }
+    start(progress, image);
+    publishRows(progress, image.header.height);
+    return;
+  }
+
+  IffReader reader(data);
+  const auto formType = reader.getFormType();
+  IffChunk chunk;
+  if (formType == "ANIM") {
+    // the image is the first frame, a whole ILBM, the next ones are deltas played by Anim
+    while (reader.next(chunk)) {
+      if (chunk.is("FORM")) {
+        parse(Span<const std::uint8_t>(chunk.data.data() - 8, chunk.data.size() + 8), file, image, progress, part);
+        return;
+      }
+    }
+    throw std::runtime_error("Error when reading the ANIM: it has no frame");
+  }
+  const auto isChunky = formType == "PBM ";
+  auto hasBody = part != Part::Image;
+  Span<const std::uint8_t> tiny;
+  while (reader.next(chunk)) {
+    if (chunk.is("BMHD")) {
+      TRACE_SCOPE("BMHD");
+      readHeader(chunk.data, image.header);
+    } else if (chunk.is("CMAP")) {
+      TRACE_SCOPE("CMAP");
+      std::memcpy(image.palette.data(), chunk.data.data(), std::min(chunk.data.size(), image.palette.size()));
+    } else if (chunk.is("CAMG")) {
+      if (chunk.data.size() < 4)
+        throw std::runtime_error("Error when reading the CAMG chunk: too short");
+      image.viewMode = readU32(chunk.data, 0);
+    } else if (chunk.is("CRNG")) {
+      TRACE_SCOPE("CRNG");
+      if (image.numCycles < image.cycles.size() - 1) {
+        readCycle(chunk.data, image.cycles[image.numCycles]);
+        image.numCycles++;
+      }
+    } else if (chunk.is("BODY") && !hasBody) {
+      TRACE_SCOPE("BODY");
+      hasBody = true;
+      prepareViewMode(isChunky, image);
+      readBody(chunk.data, isChunky, file, image, progress);
+    } else if (chunk.is("ABIT") && formType == "ACBM" && !hasBody) {
+      TRACE_SCOPE("ABIT");
+      hasBody = true;
+      prepareViewMode(isChunky, image);
+      readPlanarBody(chunk.data, getContiguousLayout(image.header), false, image, progress);
+      publishRows(progress, image.header.height);
+    } else if (chunk.is("TINY") && part == Part::Thumbnail && tiny.empty()) {
+      tiny = chunk.data;
+    }
+  }
+
+  // a CAMG after the body still applies
+  prepareViewMode(isChunky, image);
+  if (image.isHam() && !image.isTrueColor() && !image.pixels().empty())
+    ViewModes::resolveHam(image);
+
+  if (part == Part::Thumbnail) {
+    // the size of the thumbnail then rows like the ones of the BODY, interleaved for the ACBM files too
+    image.header.width = tiny.size() >= 4 ? readU16(tiny, 0) : 0;
+    image.header.height = tiny.size() >= 4 ? readU16(tiny, 2) : 0;
+    if (image.header.width > 0 && image.header.height > 0) {
+      TRACE_SCOPE("TINY");
+      readBody(tiny.subspan(4), isChunky, nullptr, image, nullptr);
+    }
+  }
+}
+
+void load(const std::string &path, Ilbm &image, Progress *progress) {
+  auto file = std::make_shared<const MappedFile>(path);
+  try {
+    parse(file->getData(), file, image, progress, Part::Image);
+  } catch (const std::runtime_error &e) {
+    std::ostringstream ss;
+    ss << path << ": " << e.what();
+    throw std::runtime_error(ss.str());
+  }
+}
+}// namespace
+
+std::unique_ptr<Ilbm> load(const std::string &path) {
+  TRACE_SCOPE("IlbmLoader::load");
+  auto image = std::make_unique<Ilbm>();
+  load(path, *image, nullptr);
+  return image;
+}
+
+void load(const std::string &path, Ilbm &image, Progress &progress) {
+  TRACE_SCOPE("IlbmLoader::load");
+  load(path, image, &progress);
+}
+
+std::unique_ptr<Ilbm> loadFromMemory(Span<const std::uint8_t> data) {
+  auto image = std::make_unique<Ilbm>();
+  parse(data, nullptr, *image, nullptr, Part::Image);
+  return image;
+}
+
+std::unique_ptr<Ilbm> loadWithoutBody(Span<const std::uint8_t> data) {
+  auto image = std::make_unique<Ilbm>();
+  parse(data, nullptr, *image, nullptr, Part::Chunks);
+  return image;
+}
+
+std::unique_ptr<Ilbm> loadThumbnail(Span<const std::uint8_t> data) {
+  auto image = std::make_unique<Ilbm>();
+  parse(data, nullptr, *image, nullptr, Part::Thumbnail);
+  if (image->header.width == 0 || image->header.height == 0)
+    return nullptr;
+  return image;
+}
+}// namespace IlbmLoader
@@ -0,0 +1,40 @@
+#ifndef COLORCYCLING__ILBMLOADER_H
+#define COLORCYCLING__ILBMLOADER_H
+
+#include "Ilbm.h"
+#include "Span.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace IlbmLoader {
+/* Follows a load from another thread. Once started is set, the other members don't change anymore and
+ * the first numRows rows of pixels are decoded, the next ones are being decoded. */
+struct Progress {
+  BitmapHeader header{};                          /* copy of the header */
+  std::array<std::uint8_t, 256 * 3> palette{};    /* copy of the palette read before the body */
+  const std::uint8_t *pixels{nullptr};            /* the indices, or the RGB pixels of the deep images */
+  std::size_t stride{0};                          /* pixels per row */
+  bool trueColor{false};
+  std::atomic<bool> started{false};
+  std::atomic<std::size_t> numRows{0};
+};
+
+/* parses an IFF PBM file, the first frame of an ANIM (see Anim.h), or maps a .ccyc scene (see SceneFile.h) without
+ * decoding it, throws std::runtime_error when it can't be opened or is truncated */
+std::unique_ptr<Ilbm> load(const std::string &path);
+/* loads into image, progress is updated as the rows of the body are decoded. The pixels stay where they
+ * are when image is moved. */
+void load(const std::string &path, Ilbm &image, Progress &progress);
+/* parses an IFF PBM file already in memory, the image doesn't refer to data */
+std::unique_ptr<Ilbm> loadFromMemory(Span<const std::uint8_t> data);
+/* parses the chunks of an IFF file in memory but its body, pixels() is empty */
+std::unique_ptr<Ilbm> loadWithoutBody(Span<const std::uint8_t> data);
+/* the thumbnail of an IFF file in memory: its TINY chunk (the size of the thumbnail then rows like the ones of
+ * the BODY) decoded with the palette and the ranges of the image, null when there is none */
+std::unique_ptr<Ilbm> loadThumbnail(Span<const std::uint8_t> data);
+}// namespace IlbmLoader
+
+#endif//COLORCYCLING__ILBMLOADER_H
@@ -0,0 +1,405 @@
+#include "IlbmWriter.h"
+#include "Planar.h"
+#include "VerticalRle.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace IlbmWriter {
+namespace {
+void putU8(std::vector<std::uint8_t> &out, std::uint8_t value) {
+  out.push_back(value);
+}
+
+void putU16(std::vector<std::uint8_t> &out, std::uint16_t value) {
+  out.push_back(static_cast<std::uint8_t>(value >> 8));
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+
+void putU32(std::vector<std::uint8_t> &out, std::uint32_t value) {
+  putU16(out, static_cast<std::uint16_t>(value >> 16));
+  putU16(out, static_cast<std::uint16_t>(value));
+}
+
+/* writes a chunk header and returns the position of its length field */
+std::size_t beginChunk(std::vector<std::uint8_t> &out, const char *id) {
+  for (auto i = 0; i < 4; i++)
+    out.push_back(static_cast<std::uint8_t>(id[i]));
+  putU32(out, 0);
+  return out.size() - 4;
+}
+
+void endChunk(std::vector<std::uint8_t> &out, std::size_t lengthPos) {
+  auto length = static_cast<std::uint32_t>(out.size() - lengthPos - 4);
+  for (auto i = 0; i < 4; i++) {
+    out[lengthPos + i] = static_cast<std::uint8_t>(length >> (24 - i * 8));
+  }
+  if (length % 2 != 0)
+    out.push_back(0);
+}
+
+/* the deep images have RGB pixels only, the HAM ones have the indices their colors are resolved from */
+bool isDeep(const Ilbm &image) {
+  return image.isTrueColor() && !image.isHam();
+}
+
+/* the bits of one plane for row y, the planes of deep images are the bits of the red, green then blue components */
+void getLine(const Ilbm &image, int y, int plane, std::vector<std::uint8_t> &line) {
+  const auto width = image.header.width;
+  std::fill(line.begin(), line.end(), 0);
+  if (isDeep(image)) {
+    const auto *rgb = image.rgb.data() + y * image.stride() * 3 + plane / 8;
+    for (auto x = 0; x < width; x++) {
+      if (rgb[x * 3] & (1 << (plane % 8)))
+        line[x / 8] |= static_cast<std::uint8_t>(0x80 >> (x % 8));
+    }
+    return;
+  }
+  const auto *pixels = image.pixels().data() + y * image.stride();
+  for (auto x = 0; x < width; x++) {
+    if (pixels[x] & (1 << plane))
+      line[x / 8] |= static_cast<std::uint8_t>(0x80 >> (x % 8));
+  }
+}
+
+/* the planes of an image one after the other, lines of Planar::getLineSize bytes */
+std::vector<std::uint8_t> getPlanes(const Ilbm &image) {
+  const auto &header = image.header;
+  const auto lineSize = Planar::getLineSize(header.width);
+  const auto planeSize = lineSize * header.height;
+  std::vector<std::uint8_t> planar(planeSize * header.num_planes, 0);
+  std::uint8_t *planes[8];
+  for (auto y = 0; y < header.height; y++) {
+    for (auto p = 0; p < header.num_planes; p++) {
+      planes[p] = planar.data() + p * planeSize + y * lineSize;
+    }
+    Planar::toPlanar(image.pixels().data() + y * image.stride(), header.width, header.num_planes, planes);
+  }
+  return planar;
+}
+
+/* Appends the ops of a column of itemSize bytes wide, from previous to next, to ops and its items to data (both
+ * are the same list for the bytes of operation 5): a skip of up to 127 rows (1 to 127), a run of one item over up to
+ * 255 rows (0, the number of rows) or up to 127 items (bit 7 set). Once it has a changed row, a compact column has no skip nor run, for the columns needing
+ * more ops than their count can hold otherwise. Returns false when there are still too many ops. */
+bool putColumn(const std::uint8_t *previous, const std::uint8_t *next, std::size_t lineSize, std::size_t height,
+               std::size_t itemSize, bool compact, std::vector<std::uint8_t> &ops, std::vector<std::uint8_t> &data) {
+  const auto item = [&](std::size_t row) { return next + row * lineSize; };
+  const auto isSame = [&](std::size_t row) { return std::memcmp(previous + row * lineSize, item(row), itemSize) == 0; };
+  const auto isEqual = [&](std::size_t a, std::size_t b) { return std::memcmp(item(a), item(b), itemSize) == 0; };
+  // the rows after the last changed one need no op
+  auto end = height;
+  while (end > 0 && isSame(end - 1))
+    end--;
+  const auto numOpsPos = ops.size();
+  ops.push_back(0);
+  std::size_t numOps = 0, row = 0;
+  auto changed = false;
+  while (row < end) {
+    std::size_t count = 1;
+    if (isSame(row) && !changed) {
+      while (row + count < end && count < 127 && isSame(row + count))
+        count++;
+      ops.push_back(static_cast<std::uint8_t>(count));
+    } else {
+      changed = compact;
+      while (!compact && row + count < end && count < 255 && isEqual(row, row + count))
+        count++;
+      if (count >= 3) {
+        ops.push_back(0);
+        ops.push_back(static_cast<std::uint8_t>(count));
+        data.insert(data.end(), item(row), item(row) + itemSize);
+      } else {
+        // up to an unchanged row or a run
+        count = 1;
+        while (row + count < end && count < 127 &&
+               (compact || (!isSame(row + count) && !(row + count + 2 < end && isEqual(row + count, row + count + 1) &&
+                                                      isEqual(row + count, row + count + 2)))))
+          count++;
+        ops.push_back(static_cast<std::uint8_t>(0x80 | count));
+        for (std::size_t k = 0; k < count; k++) {
+          data.insert(data.end(), item(row + k), item(row + k) + itemSize);
+        }
+      }
+    }
+    row += count;
+    if (++numOps > 255)
+      return false;
+  }
+  ops[numOpsPos] = static_cast<std::uint8_t>(numOps);
+  return true;
+}
+
+/* the lists of the changed planes of a DLTA chunk, 16 offsets then the lists: the one of each plane for
+ * operation 5, the opcodes of the 8 planes then their data for operation 7 */
+void putDelta(const std::vector<std::uint8_t> &previous, const std::vector<std::uint8_t> &next, const BitmapHeader &header,
+              std::size_t itemSize, std::vector<std::uint8_t> &out) {
+  const auto lineSize = Planar::getLineSize(header.width);
+  const auto planeSize = lineSize * header.height;
+  const auto start = out.size();
+  out.insert(out.end(), 16 * 4, 0);
+  const auto putOffset = [&](std::size_t index) {
+    const auto offset = static_cast<std::uint32_t>(out.size() - start);
+    for (auto i = 0; i < 4; i++) {
+      out[start + index * 4 + i] = static_cast<std::uint8_t>(offset >> (24 - i * 8));
+    }
+  };
+  std::vector<std::uint8_t> ops, data;
+  for (auto p = 0; p < header.num_planes; p++) {
+    const auto *from = previous.data() + p * planeSize;
+    const auto *to = next.data() + p * planeSize;
+    if (std::memcmp(from, to, planeSize) == 0)
+      continue;
+    ops.clear();
+    data.clear();
+    auto &items = itemSize == 1 ? ops : data;
+    for (std::size_t column = 0; column < lineSize / itemSize; column++) {
+      const auto opsSize = ops.size(), itemsSize = items.size();
+      const auto *a = from + column * itemSize, *b = to + column * itemSize;
+      if (putColumn(a, b, lineSize, header.height, itemSize, false, ops, items))
+        continue;
+      ops.resize(opsSize);
+      items.resize(itemsSize);
+      if (!putColumn(a, b, lineSize, header.height, itemSize, true, ops, items))
+        throw std::runtime_error("Error when writing an ANIM: a column needs more than 255 ops");
+    }
+    // the lists start on a word, like the data the Amiga reads them into
+    putOffset(p);
+    out.insert(out.end(), ops.begin(), ops.end());
+    if (itemSize > 1) {
+      if (out.size() % 2 != 0)
+        out.push_back(0);
+      putOffset(8 + p);
+      out.insert(out.end(), data.begin(), data.end());
+    }
+    if (out.size() % 2 != 0)
+      out.push_back(0);
+  }
+}
+
+void writeFile(const std::vector<std::uint8_t> &data, const std::string &path) {
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!os) {
+    std::ostringstream ss;
+    ss << "Error when writing " << path;
+    throw std::runtime_error(ss.str());
+  }
+}
+
+void putRow(std::vector<std::uint8_t> &out, const std::vector<std::uint8_t> &row, bool compress) {
+  if (compress) {
+    encodeByteRun1(row.data(), row.size(), out);
+  } else {
+    out.insert(out.end(), row.begin(), row.end());
+  }
+}
+
+/* the rows of a BODY or of a TINY chunk, chunky or made of one line per bitplane */
+void putRows(std::vector<std::uint8_t> &out, const Ilbm &image, bool chunky, bool compress) {
+  const auto &header = image.header;
+  if (chunky) {
+    // PBM rows are an even number of bytes long, like the rows of the image
+    std::vector<std::uint8_t> row(image.stride());
+    for (auto y = 0; y < header.height; y++) {
+      std::copy_n(image.pixels().data() + y * row.size(), row.size(), row.data());
+      putRow(out, row, compress);
+    }
+    return;
+  }
+  // lines are a multiple of 16 bits
+  std::vector<std::uint8_t> line(Planar::getLineSize(header.width));
+  for (auto y = 0; y < header.height; y++) {
+    for (auto plane = 0; plane < header.num_planes; plane++) {
+      getLine(image, y, plane, line);
+      putRow(out, line, compress);
+    }
+  }
+}
+}// namespace
+
+void encodeByteRun1(const std::uint8_t *row, std::size_t size, std::vector<std::uint8_t> &out) {
+  std::size_t i = 0;
+  while (i < size) {
+    std::size_t run = 1;
+    while (i + run < size && run < 128 && row[i + run] == row[i])
+      run++;
+    if (run >= 3) {
+      /* [-1..-127] : followed by byte to be repeated (-n)+1 times*/
+      out.push_back(static_cast<std::uint8_t>(1 - static_cast<int>(run)));
+      out.push_back(row[i]);
+      i += run;
+      continue;
+    }
+    /* [0..127]   : followed by n+1 bytes of data, stopping before the next run */
+    auto end = i;
+    while (end < size && end - i < 128) {
+      if (end + 2 < size && row[end] == row[end + 1] && row[end] == row[end + 2])
+        break;
+      end++;
+    }
+    out.push_back(static_cast<std::uint8_t>(end - i - 1));
+    out.insert(out.end(), row + i, row + end);
+    i = end;
+  }
+}
+
+std::vector<std::uint8_t> write(const Ilbm &image, FormType type, const Ilbm *thumbnail) {
+  const auto &header = image.header;
+  if (isDeep(image) && (type == FormType::Pbm || header.num_planes != 24))
+    throw std::runtime_error("Error when writing a truecolor image: it needs 24 bitplanes");
+  if (thumbnail && isDeep(*thumbnail) != isDeep(image))
+    throw std::runtime_error("Error when writing a thumbnail: it needs the pixels of its image, indices or RGB");
+  if (image.isHam() && type == FormType::Pbm)
+    throw std::runtime_error("Error when writing a HAM image: it needs bitplanes");
+  if (header.compression == 2 && type == FormType::Pbm)
+    throw std::runtime_error("Error when writing an image: vertical RLE needs bitplanes");
+  std::vector<std::uint8_t> out;
+  auto form = beginChunk(out, "FORM");
+  const auto *formType = type == FormType::Pbm ? "PBM " : type == FormType::Ilbm ? "ILBM" : "ACBM";
+  out.insert(out.end(), formType, formType + 4);
+
+  auto chunk = beginChunk(out, "BMHD");
+  putU16(out, header.width);
+  putU16(out, header.height);
+  putU16(out, static_cast<std::uint16_t>(header.x));
+  putU16(out, static_cast<std::uint16_t>(header.y));
+  putU8(out, header.num_planes);
+  putU8(out, header.masking);
+  putU8(out, type == FormType::Acbm ? 0 : header.compression);
+  putU8(out, 0);
+  putU16(out, header.transparent_color);
+  putU8(out, header.x_aspect);
+  putU8(out, header.y_aspect);
+  putU16(out, static_cast<std::uint16_t>(header.page_width));
+  putU16(out, static_cast<std::uint16_t>(header.page_height));
+  endChunk(out, chunk);
+
+  if (!isDeep(image)) {
+    chunk = beginChunk(out, "CMAP");
+    out.insert(out.end(), image.palette.begin(), image.palette.end());
+    endChunk(out, chunk);
+  }
+
+  if (image.viewMode) {
+    chunk = beginChunk(out, "CAMG");
+    putU32(out, image.viewMode);
+    endChunk(out, chunk);
+  }
+
+  for (auto i = 0; i < image.numCycles; i++) {
+    const auto &cycle = image.cycles[i];
+    chunk = beginChunk(out, "CRNG");
+    putU16(out, static_cast<std::uint16_t>(cycle.padding));
+    putU16(out, static_cast<std::uint16_t>(cycle.rate));
+    putU16(out, static_cast<std::uint16_t>(cycle.flags));
+    putU8(out, cycle.low);
+    putU8(out, cycle.high);
+    endChunk(out, chunk);
+  }
+
+  // DPaint writes the thumbnail before the body, vertical RLE has no rows to store it with
+  if (thumbnail && header.compression != 2) {
+    chunk = beginChunk(out, "TINY");
+    putU16(out, thumbnail->header.width);
+    putU16(out, thumbnail->header.height);
+    putRows(out, *thumbnail, type == FormType::Pbm, type != FormType::Acbm && header.compression == 1);
+    endChunk(out, chunk);
+  }
+
+  chunk = beginChunk(out, type == FormType::Acbm ? "ABIT" : "BODY");
+  if (type == FormType::Pbm) {
+    putRows(out, image, true, header.compression == 1);
+  } else if (type == FormType::Ilbm && header.compression == 2) {
+    // one VDAT chunk per plane
+    const auto lineSize = Planar::getLineSize(header.width);
+    std::vector<std::uint8_t> line(lineSize), plane(lineSize * header.height);
+    for (auto p = 0; p < header.num_planes; p++) {
+      for (auto y = 0; y < header.height; y++) {
+        getLine(image, y, p, line);
+        std::copy(line.begin(), line.end(), plane.begin() + y * lineSize);
+      }
+      auto vdat = beginChunk(out, "VDAT");
+      VerticalRle::encodePlane(plane.data(), lineSize, header.height, out);
+      endChunk(out, vdat);
+    }
+  } else if (type == FormType::Ilbm) {
+    putRows(out, image, false, header.compression == 1);
+  } else {
+    // uncompressed planes one after the other
+    std::vector<std::uint8_t> line(Planar::getLineSize(header.width));
+    for (auto plane = 0; plane < header.num_planes; plane++) {
+      for (auto y = 0; y < header.height; y++) {
+        getLine(image, y, plane, line);
+        out.insert(out.end(), line.begin(), line.end());
+      }
+    }
+  }
+  endChunk(out, chunk);
+
+  endChunk(out, form);
+  return out;
+}
+
+void save(const Ilbm &image, const std::string &path, FormType type, const Ilbm *thumbnail) {
+  writeFile(write(image, type, thumbnail), path);
+}
+
+std::vector<std::uint8_t> writeAnim(const std::vector<Ilbm> &frames, Delta delta, int delay) {
+  if (frames.empty())
+    throw std::runtime_error("Error when writing an ANIM: it has no frame");
+  const auto &header = frames[0].header;
+  const auto lineSize = Planar::getLineSize(header.width);
+  for (const auto &frame : frames) {
+    if (isDeep(frame) || frame.header.num_planes == 0 || frame.header.num_planes > 8)
+      throw std::runtime_error("Error when writing an ANIM: its frames need 1 to 8 bitplanes");
+    if (frame.header.width != header.width || frame.header.height != header.height || frame.header.num_planes != header.num_planes)
+      throw std::runtime_error("Error when writing an ANIM: its frames need the same size and bitplanes");
+  }
+  if (delta == Delta::Long && lineSize % 4 != 0)
+    throw std::runtime_error("Error when writing an ANIM: long deltas need a width multiple of 32");
+
+  std::vector<std::uint8_t> out;
+  auto form = beginChunk(out, "FORM");
+  out.insert(out.end(), {'A', 'N', 'I', 'M'});
+  const auto first = write(frames[0], FormType::Ilbm);
+  out.insert(out.end(), first.begin(), first.end());
+
+  std::vector<std::vector<std::uint8_t>> planes;
+  planes.reserve(frames.size());
+  for (const auto &frame : frames) {
+    planes.push_back(getPlanes(frame));
+  }
+  const auto itemSize = delta == Delta::Byte ? 1u : delta == Delta::Short ? 2u : 4u;
+  for (std::size_t i = 1; i < planes.size(); i++) {
+    auto frameForm = beginChunk(out, "FORM");
+    out.insert(out.end(), {'I', 'L', 'B', 'M'});
+    auto chunk = beginChunk(out, "ANHD");
+    putU8(out, delta == Delta::Byte ? 5 : 7);
+    putU8(out, 0);
+    putU16(out, header.width);
+    putU16(out, header.height);
+    putU16(out, 0);
+    putU16(out, 0);
+    putU32(out, static_cast<std::uint32_t>(i * delay));
+    putU32(out, static_cast<std::uint32_t>(delay));
+    // interleave 0: each delta goes from the frame before the previous one, from the first one for the second frame
+    putU8(out, 0);
+    putU8(out, 0);
+    putU32(out, delta == Delta::Long ? 1 : 0);
+    out.insert(out.end(), 16, 0);
+    endChunk(out, chunk);
+    chunk = beginChunk(out, "DLTA");
+    putDelta(planes[i >= 2 ? i - 2 : 0], planes[i], header, itemSize, out);
+    endChunk(out, chunk);
+    endChunk(out, frameForm);
+  }
+  endChunk(out, form);
+  return out;
+}
+
+void saveAnim(const std::vector<Ilbm> &frames, const std::string &path, Delta delta, int delay) {
+  writeFile(writeAnim(frames, delta, delay), path);
+}
+}// namespace IlbmWriter
@@ -0,0 +1,35 @@
+#ifndef COLORCYCLING__ILBMWRITER_H
+#define COLORCYCLING__ILBMWRITER_H
+
+#include "Ilbm.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace IlbmWriter {
+/* chunky (one byte per pixel), interleaved bitplanes or contiguous bitplanes (ABIT chunk) body */
+enum class FormType { Pbm, Ilbm, Acbm };
+
+/* appends a row compressed with ByteRun1 (PackBits) to out */
+void encodeByteRun1(const std::uint8_t *row, std::size_t size, std::vector<std::uint8_t> &out);
+/* serializes an image as an IFF file, the BODY is compressed with ByteRun1 when header.compression is 1 (never
+ * for ACBM) and with vertical RLE when it is 2 (ILBM only),
+ * ILBM and ACBM bodies have header.num_planes bitplanes, 24 for the truecolor images.
+ * a CAMG chunk holds viewMode when it isn't 0, HAM images are written from their indices.
+ * thumbnail, with the planes of image, is written as a TINY chunk (interleaved for ACBM, none with vertical RLE) */
+std::vector<std::uint8_t> write(const Ilbm &image, FormType type = FormType::Pbm, const Ilbm *thumbnail = nullptr);
+/* writes an image to a file, throws std::runtime_error on failure */
+void save(const Ilbm &image, const std::string &path, FormType type = FormType::Pbm, const Ilbm *thumbnail = nullptr);
+
+/* the deltas of the frames of an ANIM: operation 5 (bytes) or 7 (shorts or longs) */
+enum class Delta { Byte, Short, Long };
+/* Serializes frames of the same size and bitplanes (1 to 8) as an ANIM: the first one as an ILBM, the next ones as
+ * vertical deltas from the frame before the previous one, shown delay ticks (1/60 s) each. The long deltas need a
+ * width multiple of 32. The palette and the ranges are the ones of the first frame. */
+std::vector<std::uint8_t> writeAnim(const std::vector<Ilbm> &frames, Delta delta = Delta::Byte, int delay = 1);
+/* writes an ANIM to a file, throws std::runtime_error on failure */
+void saveAnim(const std::vector<Ilbm> &frames, const std::string &path, Delta delta = Delta::Byte, int delay = 1);
+}// namespace IlbmWriter
+
+#endif//COLORCYCLING__ILBMWRITER_H
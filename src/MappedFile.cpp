@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+#include <sstream>
+#include <stdexcept>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+[[noreturn]] void fail(const char *action, const std::string &path) {
+  std::ostringstream ss;
+  ss << "Error when " << action << " " << path;
+  throw std::runtime_error(ss.str());
+}
+}// namespace
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &path) {
+  m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    fail("opening", path);
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size)) {
+    CloseHandle(m_file);
+    fail("reading the size of", path);
+  }
+  m_size = static_cast<std::size_t>(size.QuadPart);
+  if (m_size == 0)
+    return;
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping)
+    m_data = static_cast<const std::uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!m_data) {
+    if (m_mapping)
+      CloseHandle(m_mapping);
+    CloseHandle(m_file);
+    fail("mapping", path);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (m_data)
+    UnmapViewOfFile(m_data);
+  if (m_mapping)
+    CloseHandle(m_mapping);
+  if (m_file)
+    CloseHandle(m_file);
+}
+#else
+MappedFile::MappedFile(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    fail("opening", path);
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+    close(fd);
+    fail("opening", path);
+  }
+  m_size = static_cast<std::size_t>(status.st_size);
+  if (m_size > 0) {
+    auto *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      fail("mapping", path);
+    }
+    // the whole file is about to be read, start reading it ahead
+    madvise(data, m_size, MADV_WILLNEED);
+    m_data = static_cast<const std::uint8_t *>(data);
+  }
+  // the mapping stays valid without the descriptor
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (m_data)
+    munmap(const_cast<std::uint8_t *>(m_data), m_size);
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef COLORCYCLING__MAPPEDFILE_H
+#define COLORCYCLING__MAPPEDFILE_H
+
+#include "Span.h"
+#include <cstdint>
+#include <string>
+
+/* read-only memory mapping of a whole file */
+class MappedFile {
+public:
+  /* throws std::runtime_error when the file can't be opened or mapped */
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  [[nodiscard]] Span<const std::uint8_t> getData() const { return {m_data, m_size}; }
+
+private:
+  const std::uint8_t *m_data{nullptr};
+  std::size_t m_size{0};
+#ifdef _WIN32
+  void *m_file{nullptr};
+  void *m_mapping{nullptr};
+#endif
+};
+
+#endif//COLORCYCLING__MAPPEDFILE_H
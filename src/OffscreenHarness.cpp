@@ -0,0 +1,209 @@
+#include "OffscreenHarness.h"
+#include "ColorCycler.h"
+#include "IlbmLoader.h"
+#include "PaletteExpand.h"
+#include "Renderer.h"
+#include "Statistics.h"
+#include "Window.h"
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace OffscreenHarness {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void printSummary(const char *phase, const std::vector<double> &samples) {
+  auto summary = Statistics::summarize(samples);
+  std::printf("%-26s %9.3f %9.3f %9.3f %9.3f %9.3f\n", phase, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+}
+
+/* a color attachment of the size of the image */
+class Framebuffer {
+public:
+  Framebuffer(int width, int height) {
+    glGenRenderbuffers(1, &m_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+    m_complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  }
+
+  ~Framebuffer() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteRenderbuffers(1, &m_colorBuffer);
+  }
+
+  [[nodiscard]] bool isComplete() const { return m_complete; }
+
+private:
+  unsigned int m_framebuffer{0}, m_colorBuffer{0};
+  bool m_complete{false};
+};
+
+/* GPU time of a phase with a GL_TIME_ELAPSED query, when the driver supports it */
+class GpuTimer {
+public:
+  GpuTimer() : m_supported(GLEW_ARB_timer_query) {
+    if (m_supported)
+      glGenQueries(1, &m_query);
+  }
+
+  ~GpuTimer() {
+    if (m_supported)
+      glDeleteQueries(1, &m_query);
+  }
+
+  [[nodiscard]] bool isSupported() const { return m_supported; }
+
+  void begin() const {
+    if (m_supported)
+      glBeginQuery(GL_TIME_ELAPSED, m_query);
+  }
+
+  void end() const {
+    if (m_supported)
+      glEndQuery(GL_TIME_ELAPSED);
+  }
+
+  /* waits for the result, in milliseconds */
+  [[nodiscard]] double getMs() const {
+    if (!m_supported)
+      return 0;
+    GLuint64 ns = 0;
+    glGetQueryObjectui64v(m_query, GL_QUERY_RESULT, &ns);
+    return static_cast<double>(ns) / 1e6;
+  }
+
+private:
+  bool m_supported{false};
+  unsigned int m_query{0};
+};
+
+/* the framebuffer is read bottom-up, the CPU expansion top-down with rows of stride pixels */
+std::size_t countMismatches(const std::vector<std::uint8_t> &gl, const std::vector<std::uint8_t> &cpu, int width, int height, std::size_t stride) {
+  std::size_t mismatches = 0;
+  const auto rowSize = static_cast<std::size_t>(width) * 4;
+  for (auto y = 0; y < height; y++) {
+    const auto *glRow = gl.data() + (height - 1 - y) * rowSize;
+    const auto *cpuRow = cpu.data() + y * stride * 4;
+    for (std::size_t x = 0; x < rowSize; x += 4) {
+      if (std::memcmp(glRow + x, cpuRow + x, 3) != 0)
+        mismatches++;
+    }
+  }
+  return mismatches;
+}
+}// namespace
+
+int run(const std::string &path, int frames) {
+  std::unique_ptr<Ilbm> image;
+  try {
+    image = IlbmLoader::load(path);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int width = image->header.width;
+  const int height = image->header.height;
+  const auto stride = image->stride();
+  const auto numPixels = stride * height;
+  if (image->isTrueColor()) {
+    std::cerr << path << ": deep images have no palette to cycle" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (width == 0 || image->pixels().size() < numPixels) {
+    std::cerr << path << ": no decodable image body" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Window window;
+  window.init(true);
+  window.setVerticalSyncEnabled(false);
+  std::printf("renderer: %s, OpenGL %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+  std::vector<double> cycle, upload, draw, readback, gpuUpload, gpuDraw, total, cpuExpand;
+  std::size_t mismatches = 0;
+  {
+    Renderer renderer;
+    renderer.init();
+    renderer.setImage(*image);
+
+    Framebuffer framebuffer(width, height);
+    if (!framebuffer.isComplete()) {
+      std::cerr << "Error when creating the framebuffer object" << std::endl;
+      return EXIT_FAILURE;
+    }
+    renderer.reshape(width, height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    ColorCycler cycler;
+    cycler.setBasePalette(image->palette);
+    GpuTimer uploadTimer, drawTimer;
+    std::vector<std::uint8_t> pixels(static_cast<std::size_t>(width) * height * 4), expanded(numPixels * 4);
+    for (auto frame = 0; frame < frames; frame++) {
+      auto start = Clock::now();
+      cycler.step(*image);
+      cycle.push_back(elapsedMs(start));
+
+      // each phase ends with glFinish so that its wall time can be attributed to it
+      start = Clock::now();
+      uploadTimer.begin();
+      renderer.updatePalette(*image);
+      uploadTimer.end();
+      glFinish();
+      upload.push_back(elapsedMs(start));
+
+      auto phaseStart = Clock::now();
+      drawTimer.begin();
+      renderer.draw();
+      drawTimer.end();
+      glFinish();
+      draw.push_back(elapsedMs(phaseStart));
+
+      phaseStart = Clock::now();
+      glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+      readback.push_back(elapsedMs(phaseStart));
+      total.push_back(elapsedMs(start));
+
+      if (uploadTimer.isSupported()) {
+        gpuUpload.push_back(uploadTimer.getMs());
+        gpuDraw.push_back(drawTimer.getMs());
+      }
+
+      start = Clock::now();
+      PaletteExpand::toRgba(image->pixels().data(), numPixels, image->palette.data(), expanded.data());
+      cpuExpand.push_back(elapsedMs(start));
+      mismatches += countMismatches(pixels, expanded, width, height, stride);
+    }
+  }
+
+  std::printf("%d frames %dx%d\n", frames, width, height);
+  std::printf("%-26s %9s %9s %9s %9s %9s\n", "phase (ms)", "mean", "p50", "p95", "p99", "max");
+  printSummary("cycle (cpu)", cycle);
+  printSummary("palette upload", upload);
+  printSummary("draw", draw);
+  printSummary("readback", readback);
+  if (!gpuUpload.empty()) {
+    printSummary("palette upload (gpu timer)", gpuUpload);
+    printSummary("draw (gpu timer)", gpuDraw);
+  }
+  printSummary("gl path total", total);
+  auto cpuName = std::string("cpu expansion (") + PaletteExpand::getKernelName(PaletteExpand::getKernel()) + ")";
+  printSummary(cpuName.c_str(), cpuExpand);
+  std::printf("pixels differing from the cpu expansion: %zu\n", mismatches);
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+}// namespace OffscreenHarness
@@ -0,0 +1,13 @@
+#ifndef COLORCYCLING__OFFSCREENHARNESS_H
+#define COLORCYCLING__OFFSCREENHARNESS_H
+
+#include <string>
+
+/* Renders frames of an image into a framebuffer object of a hidden window and reads them back,
+ * to measure the GL path on machines without a GPU (Mesa llvmpipe). */
+namespace OffscreenHarness {
+/* returns the process exit code */
+int run(const std::string &path, int frames);
+}// namespace OffscreenHarness
+
+#endif//COLORCYCLING__OFFSCREENHARNESS_H
@@ -0,0 +1,112 @@
+#include "PaletteExpand.h"
+#include "CpuFeatures.h"
+#include "PaletteExpandKernels.h"
+#include <cstring>
+#include <initializer_list>
+
+namespace PaletteExpand {
+namespace Kernels {
+void buildLut(const std::uint8_t *palette, std::uint8_t (*lut)[4]) {
+  for (auto i = 0; i < 256; i++) {
+    lut[i][0] = palette[i * 3];
+    lut[i][1] = palette[i * 3 + 1];
+    lut[i][2] = palette[i * 3 + 2];
+    lut[i][3] = 0xff;
+  }
+}
+
+void toRgbScalar(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb) {
+  if (!count)
+    return;
+  alignas(4) std::uint8_t lut[256][4];
+  buildLut(palette, lut);
+  // write 4 bytes and advance by 3, the last pixel is copied separately to stay in bounds
+  for (std::size_t i = 0; i < count - 1; i++) {
+    std::memcpy(rgb, lut[indices[i]], 4);
+    rgb += 3;
+  }
+  std::memcpy(rgb, palette + indices[count - 1] * 3, 3);
+}
+
+void toRgbaScalar(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba) {
+  alignas(4) std::uint8_t lut[256][4];
+  buildLut(palette, lut);
+  for (std::size_t i = 0; i < count; i++) {
+    std::memcpy(rgba + i * 4, lut[indices[i]], 4);
+  }
+}
+}// namespace Kernels
+
+namespace {
+struct Dispatch {
+  Kernel kernel;
+  Kernels::ExpandFunction toRgb;
+  Kernels::ExpandFunction toRgba;
+};
+
+Dispatch getDispatch(Kernel kernel) {
+  switch (kernel) {
+#ifdef COLORCYCLING_X86_KERNELS
+  case Kernel::Sse41: return {kernel, Kernels::toRgbSse41, Kernels::toRgbaSse41};
+  case Kernel::Avx2: return {kernel, Kernels::toRgbAvx2, Kernels::toRgbaAvx2};
+  case Kernel::Avx512Vbmi: return {kernel, Kernels::toRgbAvx512Vbmi, Kernels::toRgbaAvx512Vbmi};
+#endif
+  default: return {Kernel::Scalar, Kernels::toRgbScalar, Kernels::toRgbaScalar};
+  }
+}
+
+Dispatch &getCurrent() {
+  static Dispatch dispatch = [] {
+    // the SSE4.1 kernel needs 16 lookups per pixel and is slower than the scalar one, it's only used when forced
+    for (auto kernel : {Kernel::Avx512Vbmi, Kernel::Avx2}) {
+      if (isSupported(kernel))
+        return getDispatch(kernel);
+    }
+    return getDispatch(Kernel::Scalar);
+  }();
+  return dispatch;
+}
+}// namespace
+
+const char *getKernelName(Kernel kernel) {
+  switch (kernel) {
+  case Kernel::Scalar: return "scalar";
+  case Kernel::Sse41: return "sse4.1";
+  case Kernel::Avx2: return "avx2";
+  case Kernel::Avx512Vbmi: return "avx512vbmi";
+  }
+  return "unknown";
+}
+
+bool isSupported(Kernel kernel) {
+  [[maybe_unused]] const auto &cpu = CpuFeatures::get();
+  switch (kernel) {
+  case Kernel::Scalar: return true;
+#ifdef COLORCYCLING_X86_KERNELS
+  case Kernel::Sse41: return cpu.sse41;
+  case Kernel::Avx2: return cpu.avx2;
+  case Kernel::Avx512Vbmi: return cpu.avx512vbmi;
+#endif
+  default: return false;
+  }
+}
+
+Kernel getKernel() {
+  return getCurrent().kernel;
+}
+
+bool setKernel(Kernel kernel) {
+  if (!isSupported(kernel))
+    return false;
+  getCurrent() = getDispatch(kernel);
+  return true;
+}
+
+void toRgb(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb) {
+  getCurrent().toRgb(indices, count, palette, rgb);
+}
+
+void toRgba(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba) {
+  getCurrent().toRgba(indices, count, palette, rgba);
+}
+}// namespace PaletteExpand
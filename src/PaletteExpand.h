@@ -0,0 +1,31 @@
+#ifndef COLORCYCLING__PALETTEEXPAND_H
+#define COLORCYCLING__PALETTEEXPAND_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* CPU equivalent of the fragment shader: turns color indices into colors */
+namespace PaletteExpand {
+enum class Kernel {
+  Scalar,
+  Sse41,     /* pshufb lookups in 16 entries slices of the palette */
+  Avx2,      /* 32-bit gathers from a padded palette */
+  Avx512Vbmi,/* vpermi2b lookups in the palette held in registers */
+};
+
+const char *getKernelName(Kernel kernel);
+/* true when the kernel has been compiled in and the CPU can run it */
+bool isSupported(Kernel kernel);
+/* the kernel used by toRgb/toRgba, by default the fastest supported one */
+Kernel getKernel();
+/* forces a kernel (not thread safe, call it before expanding), returns false
+ * and keeps the current one when it isn't supported */
+bool setKernel(Kernel kernel);
+
+/* expands count indices through a 256 entries RGB palette into packed RGB (3 bytes per pixel) */
+void toRgb(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb);
+/* expands count indices through a 256 entries RGB palette into RGBA with an opaque alpha */
+void toRgba(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba);
+}// namespace PaletteExpand
+
+#endif//COLORCYCLING__PALETTEEXPAND_H
@@ -0,0 +1,51 @@
+#include "PaletteExpandKernels.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace PaletteExpand::Kernels {
+namespace {
+/* gathers the RGBA colors of 8 indices */
+inline __m256i gather8(const int *lut, const std::uint8_t *indices) {
+  const auto offsets = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(indices)));
+  return _mm256_i32gather_epi32(lut, offsets, 4);
+}
+}// namespace
+
+void toRgbAvx2(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb) {
+  alignas(32) std::uint8_t lut[256][4];
+  buildLut(palette, lut);
+  const auto *lutWords = reinterpret_cast<const int *>(lut);
+  // drop the alpha bytes in each lane, then move the 2x12 RGB bytes next to each other
+  const auto packLanes = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  const auto joinLanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const auto c0 = gather8(lutWords, indices + i);
+    const auto c1 = gather8(lutWords, indices + i + 8);
+    const auto p0 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(c0, packLanes), joinLanes);
+    const auto p1 = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(c1, packLanes), joinLanes);
+    auto *out = rgb + i * 3;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(p0));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 16), _mm256_extracti128_si256(p0, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 24), _mm256_castsi256_si128(p1));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + 40), _mm256_extracti128_si256(p1, 1));
+  }
+  toRgbScalar(indices + i, count - i, palette, rgb + i * 3);
+}
+
+void toRgbaAvx2(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba) {
+  alignas(32) std::uint8_t lut[256][4];
+  buildLut(palette, lut);
+  const auto *lutWords = reinterpret_cast<const int *>(lut);
+  std::size_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    auto *out = reinterpret_cast<__m256i *>(rgba + i * 4);
+    _mm256_storeu_si256(out, gather8(lutWords, indices + i));
+    _mm256_storeu_si256(out + 1, gather8(lutWords, indices + i + 8));
+    _mm256_storeu_si256(out + 2, gather8(lutWords, indices + i + 16));
+    _mm256_storeu_si256(out + 3, gather8(lutWords, indices + i + 24));
+  }
+  toRgbaScalar(indices + i, count - i, palette, rgba + i * 4);
+}
+}// namespace PaletteExpand::Kernels
@@ -0,0 +1,98 @@
+#include "PaletteExpandKernels.h"
+#include <immintrin.h>
+
+namespace PaletteExpand::Kernels {
+namespace {
+/* one channel of the palette held in 4 registers of 64 entries */
+struct ChannelTable {
+  __m512i t0, t1, t2, t3;
+
+  ChannelTable(const std::uint8_t *palette, int channel) {
+    alignas(64) std::uint8_t table[256];
+    for (auto i = 0; i < 256; i++) {
+      table[i] = palette[i * 3 + channel];
+    }
+    t0 = _mm512_load_si512(table);
+    t1 = _mm512_load_si512(table + 64);
+    t2 = _mm512_load_si512(table + 128);
+    t3 = _mm512_load_si512(table + 192);
+  }
+
+  /* vpermi2b looks up 128 entries with the low 7 bits, the top bit selects the half */
+  [[nodiscard]] __m512i lookup(__m512i indices, __mmask64 upperHalf) const {
+    const auto lo = _mm512_permutex2var_epi8(t0, indices, t1);
+    const auto hi = _mm512_permutex2var_epi8(t2, indices, t3);
+    return _mm512_mask_blend_epi8(upperHalf, lo, hi);
+  }
+};
+
+struct Tables {
+  ChannelTable r, g, b;
+
+  explicit Tables(const std::uint8_t *palette) : r(palette, 0), g(palette, 1), b(palette, 2) {}
+
+  /* expands 64 indices into 4 registers of 16 RGBA colors */
+  void toRgba(const std::uint8_t *indices, __m512i out[4]) const {
+    const auto idx = _mm512_loadu_si512(indices);
+    const auto upperHalf = _mm512_movepi8_mask(idx);
+    const auto red = r.lookup(idx, upperHalf);
+    const auto green = g.lookup(idx, upperHalf);
+    const auto blue = b.lookup(idx, upperHalf);
+    const auto alpha = _mm512_set1_epi8(static_cast<char>(0xff));
+
+    // interleaving works within the 128-bit lanes: p0 holds the colors 0-3 of each lane, p1 4-7...
+    const auto rgLo = _mm512_unpacklo_epi8(red, green);
+    const auto rgHi = _mm512_unpackhi_epi8(red, green);
+    const auto baLo = _mm512_unpacklo_epi8(blue, alpha);
+    const auto baHi = _mm512_unpackhi_epi8(blue, alpha);
+    const auto p0 = _mm512_unpacklo_epi16(rgLo, baLo);
+    const auto p1 = _mm512_unpackhi_epi16(rgLo, baLo);
+    const auto p2 = _mm512_unpacklo_epi16(rgHi, baHi);
+    const auto p3 = _mm512_unpackhi_epi16(rgHi, baHi);
+
+    // 4x4 transpose of the 128-bit lanes to restore the pixel order
+    const auto t0 = _mm512_shuffle_i64x2(p0, p1, 0x44);
+    const auto t1 = _mm512_shuffle_i64x2(p2, p3, 0x44);
+    const auto t2 = _mm512_shuffle_i64x2(p0, p1, 0xee);
+    const auto t3 = _mm512_shuffle_i64x2(p2, p3, 0xee);
+    out[0] = _mm512_shuffle_i64x2(t0, t1, 0x88);
+    out[1] = _mm512_shuffle_i64x2(t0, t1, 0xdd);
+    out[2] = _mm512_shuffle_i64x2(t2, t3, 0x88);
+    out[3] = _mm512_shuffle_i64x2(t2, t3, 0xdd);
+  }
+};
+}// namespace
+
+void toRgbAvx512Vbmi(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb) {
+  const Tables tables(palette);
+  // drops the alpha bytes: 16 RGBA colors become 48 RGB bytes
+  alignas(64) std::uint8_t drop[64];
+  for (auto k = 0; k < 64; k++) {
+    drop[k] = static_cast<std::uint8_t>(k < 48 ? (k / 3) * 4 + k % 3 : 0);
+  }
+  const auto dropAlpha = _mm512_load_si512(drop);
+  constexpr __mmask64 rgbBytes = 0xffffffffffffULL;
+  std::size_t i = 0;
+  for (; i + 64 <= count; i += 64) {
+    __m512i colors[4];
+    tables.toRgba(indices + i, colors);
+    for (auto v = 0; v < 4; v++) {
+      _mm512_mask_storeu_epi8(rgb + i * 3 + v * 48, rgbBytes, _mm512_permutexvar_epi8(dropAlpha, colors[v]));
+    }
+  }
+  toRgbScalar(indices + i, count - i, palette, rgb + i * 3);
+}
+
+void toRgbaAvx512Vbmi(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba) {
+  const Tables tables(palette);
+  std::size_t i = 0;
+  for (; i + 64 <= count; i += 64) {
+    __m512i colors[4];
+    tables.toRgba(indices + i, colors);
+    for (auto v = 0; v < 4; v++) {
+      _mm512_storeu_si512(rgba + (i + v * 16) * 4, colors[v]);
+    }
+  }
+  toRgbaScalar(indices + i, count - i, palette, rgba + i * 4);
+}
+}// namespace PaletteExpand::Kernels
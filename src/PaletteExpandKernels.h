@@ -0,0 +1,27 @@
+#ifndef COLORCYCLING__PALETTEEXPANDKERNELS_H
+#define COLORCYCLING__PALETTEEXPANDKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* the kernels behind PaletteExpand, each one is compiled with its own instruction set flags */
+namespace PaletteExpand::Kernels {
+using ExpandFunction = void (*)(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *out);
+
+/* pads the palette to 4 bytes per entry (RGB + opaque alpha) */
+void buildLut(const std::uint8_t *palette, std::uint8_t (*lut)[4]);
+
+void toRgbScalar(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb);
+void toRgbaScalar(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba);
+
+#ifdef COLORCYCLING_X86_KERNELS
+void toRgbSse41(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb);
+void toRgbaSse41(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba);
+void toRgbAvx2(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb);
+void toRgbaAvx2(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba);
+void toRgbAvx512Vbmi(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb);
+void toRgbaAvx512Vbmi(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba);
+#endif
+}// namespace PaletteExpand::Kernels
+
+#endif//COLORCYCLING__PALETTEEXPANDKERNELS_H
@@ -0,0 +1,93 @@
+#include "PaletteExpandKernels.h"
+#include <smmintrin.h>
+
+namespace PaletteExpand::Kernels {
+namespace {
+/* the palette split in one table per channel, each one made of 16 slices of 16 entries for pshufb */
+struct ChannelTables {
+  __m128i r[16], g[16], b[16];
+
+  explicit ChannelTables(const std::uint8_t *palette) {
+    alignas(16) std::uint8_t slice[3][16];
+    for (auto h = 0; h < 16; h++) {
+      for (auto i = 0; i < 16; i++) {
+        for (auto c = 0; c < 3; c++) {
+          slice[c][i] = palette[(h * 16 + i) * 3 + c];
+        }
+      }
+      r[h] = _mm_load_si128(reinterpret_cast<const __m128i *>(slice[0]));
+      g[h] = _mm_load_si128(reinterpret_cast<const __m128i *>(slice[1]));
+      b[h] = _mm_load_si128(reinterpret_cast<const __m128i *>(slice[2]));
+    }
+  }
+
+  /* looks up 16 indices, for each slice the indices outside of it get their top bit set so pshufb zeroes them */
+  void lookup(__m128i indices, __m128i &red, __m128i &green, __m128i &blue) const {
+    const auto bias = _mm_set1_epi8(0x70);
+    red = green = blue = _mm_setzero_si128();
+    for (auto h = 0; h < 16; h++) {
+      const auto local = _mm_xor_si128(indices, _mm_set1_epi8(static_cast<char>(h << 4)));
+      const auto selector = _mm_adds_epu8(local, bias);
+      red = _mm_or_si128(red, _mm_shuffle_epi8(r[h], selector));
+      green = _mm_or_si128(green, _mm_shuffle_epi8(g[h], selector));
+      blue = _mm_or_si128(blue, _mm_shuffle_epi8(b[h], selector));
+    }
+  }
+};
+
+/* pshufb masks interleaving 16 red, green and blue bytes into 48 RGB bytes */
+struct RgbMasks {
+  __m128i masks[3][3];// [output vector][channel]
+
+  RgbMasks() {
+    alignas(16) std::int8_t mask[16];
+    for (auto v = 0; v < 3; v++) {
+      for (auto c = 0; c < 3; c++) {
+        for (auto k = 0; k < 16; k++) {
+          const auto pos = v * 16 + k;
+          mask[k] = pos % 3 == c ? static_cast<std::int8_t>(pos / 3) : static_cast<std::int8_t>(-128);
+        }
+        masks[v][c] = _mm_load_si128(reinterpret_cast<const __m128i *>(mask));
+      }
+    }
+  }
+};
+}// namespace
+
+void toRgbSse41(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgb) {
+  const ChannelTables tables(palette);
+  static const RgbMasks rgbMasks;
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i red, green, blue;
+    tables.lookup(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)), red, green, blue);
+    for (auto v = 0; v < 3; v++) {
+      const auto &masks = rgbMasks.masks[v];
+      const auto out = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(red, masks[0]), _mm_shuffle_epi8(green, masks[1])),
+                                    _mm_shuffle_epi8(blue, masks[2]));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(rgb + i * 3 + v * 16), out);
+    }
+  }
+  toRgbScalar(indices + i, count - i, palette, rgb + i * 3);
+}
+
+void toRgbaSse41(const std::uint8_t *indices, std::size_t count, const std::uint8_t *palette, std::uint8_t *rgba) {
+  const ChannelTables tables(palette);
+  const auto alpha = _mm_set1_epi8(static_cast<char>(0xff));
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i red, green, blue;
+    tables.lookup(_mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + i)), red, green, blue);
+    const auto rgLo = _mm_unpacklo_epi8(red, green);
+    const auto rgHi = _mm_unpackhi_epi8(red, green);
+    const auto baLo = _mm_unpacklo_epi8(blue, alpha);
+    const auto baHi = _mm_unpackhi_epi8(blue, alpha);
+    auto *out = reinterpret_cast<__m128i *>(rgba + i * 4);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(rgLo, baLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLo, baLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHi, baHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHi, baHi));
+  }
+  toRgbaScalar(indices + i, count - i, palette, rgba + i * 4);
+}
+}// namespace PaletteExpand::Kernels
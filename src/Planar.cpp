@@ -0,0 +1,141 @@
+#include "Planar.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLORCYCLING_PLANAR_SSE2
+#endif
+
+namespace Planar {
+namespace {
+/* Transposes the 8x8 bit matrix held in x, byte 7 - p being the byte of plane p for 8 pixels. Afterwards
+ * byte k holds the chunky value of pixel k. The bit of row r and column c is bit 8r + c, each step
+ * swaps the blocks on the diagonal of 2x2, 4x4 then 8x8 blocks, which mirrors the matrix across its anti-diagonal. */
+inline std::uint64_t transpose(std::uint64_t x) {
+  auto t = (x ^ (x >> 9)) & 0x0055005500550055ull;
+  x ^= t ^ (t << 9);
+  t = (x ^ (x >> 18)) & 0x0000333300003333ull;
+  x ^= t ^ (t << 18);
+  t = (x ^ (x >> 36)) & 0x000000000F0F0F0Full;
+  x ^= t ^ (t << 36);
+  return x;
+}
+
+/* the 8 pixels of group (8 pixels per byte of a line) */
+inline std::uint64_t convertGroup(const std::uint8_t *const *planes, int numPlanes, std::size_t group) {
+  std::uint64_t x = 0;
+  for (auto p = 0; p < numPlanes; p++) {
+    x |= static_cast<std::uint64_t>(planes[p][group]) << (8 * (7 - p));
+  }
+  return transpose(x);
+}
+
+inline void store(std::uint64_t x, std::uint8_t *out, std::size_t count) {
+  for (std::size_t k = 0; k < count; k++) {
+    out[k] = static_cast<std::uint8_t>(x >> (8 * k));
+  }
+}
+
+/* converts the groups from firstGroup to the end of the line */
+void convertTail(const std::uint8_t *const *planes, int numPlanes, std::size_t firstGroup, std::size_t width, std::uint8_t *chunky) {
+  const auto numFullGroups = width / 8;
+  for (auto group = firstGroup; group < numFullGroups; group++) {
+    store(convertGroup(planes, numPlanes, group), chunky + group * 8, 8);
+  }
+  if (width % 8 != 0)
+    store(convertGroup(planes, numPlanes, numFullGroups), chunky + numFullGroups * 8, width % 8);
+}
+
+#ifdef COLORCYCLING_PLANAR_SSE2
+/* transpose on the two 64-bit lanes */
+inline __m128i transpose(__m128i x) {
+  auto t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 9)), _mm_set1_epi64x(0x0055005500550055ll));
+  x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 9)));
+  t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 18)), _mm_set1_epi64x(0x0000333300003333ll));
+  x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 18)));
+  t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 36)), _mm_set1_epi64x(0x000000000F0F0F0Fll));
+  return _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 36)));
+}
+
+/* 128 pixels: 16 bytes of each plane are interleaved into the 64-bit words of 16 groups, then transposed */
+void convert128(const std::uint8_t *const *planes, int numPlanes, std::size_t offset, std::uint8_t *chunky) {
+  __m128i p[8];
+  for (auto i = 0; i < 8; i++) {
+    p[i] = i < numPlanes ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(planes[i] + offset)) : _mm_setzero_si128();
+  }
+  // plane 7 goes to the first byte of each word
+  const auto a0 = _mm_unpacklo_epi8(p[7], p[6]), a1 = _mm_unpackhi_epi8(p[7], p[6]);
+  const auto a2 = _mm_unpacklo_epi8(p[5], p[4]), a3 = _mm_unpackhi_epi8(p[5], p[4]);
+  const auto a4 = _mm_unpacklo_epi8(p[3], p[2]), a5 = _mm_unpackhi_epi8(p[3], p[2]);
+  const auto a6 = _mm_unpacklo_epi8(p[1], p[0]), a7 = _mm_unpackhi_epi8(p[1], p[0]);
+  const auto b0 = _mm_unpacklo_epi16(a0, a2), b1 = _mm_unpackhi_epi16(a0, a2);
+  const auto b2 = _mm_unpacklo_epi16(a1, a3), b3 = _mm_unpackhi_epi16(a1, a3);
+  const auto b4 = _mm_unpacklo_epi16(a4, a6), b5 = _mm_unpackhi_epi16(a4, a6);
+  const auto b6 = _mm_unpacklo_epi16(a5, a7), b7 = _mm_unpackhi_epi16(a5, a7);
+  const __m128i words[8] = {_mm_unpacklo_epi32(b0, b4), _mm_unpackhi_epi32(b0, b4), _mm_unpacklo_epi32(b1, b5), _mm_unpackhi_epi32(b1, b5),
+                            _mm_unpacklo_epi32(b2, b6), _mm_unpackhi_epi32(b2, b6), _mm_unpacklo_epi32(b3, b7), _mm_unpackhi_epi32(b3, b7)};
+  for (auto i = 0; i < 8; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(chunky + i * 16), transpose(words[i]));
+  }
+}
+#endif
+}// namespace
+
+void toChunkySwar(const std::uint8_t *const *planes, int numPlanes, std::size_t width, std::uint8_t *chunky) {
+  convertTail(planes, std::min(numPlanes, 8), 0, width, chunky);
+}
+
+void toChunky(const std::uint8_t *const *planes, int numPlanes, std::size_t width, std::uint8_t *chunky) {
+  numPlanes = std::min(numPlanes, 8);
+  std::size_t group = 0;
+#ifdef COLORCYCLING_PLANAR_SSE2
+  for (; group + 16 <= width / 8; group += 16) {
+    convert128(planes, numPlanes, group, chunky + group * 8);
+  }
+#endif
+  convertTail(planes, numPlanes, group, width, chunky);
+}
+
+void toRgb(const std::uint8_t *const *planes, std::size_t width, std::uint8_t *rgb) {
+  // each component is converted like 8 planes of indices, a block at a time, then interleaved
+  constexpr std::size_t BlockSize = 256;
+  std::uint8_t components[3][BlockSize];
+  const std::uint8_t *blockPlanes[24];
+  for (std::size_t x = 0; x < width; x += BlockSize) {
+    const auto count = std::min(BlockSize, width - x);
+    for (auto p = 0; p < 24; p++) {
+      blockPlanes[p] = planes[p] + x / 8;
+    }
+    for (auto c = 0; c < 3; c++) {
+      toChunky(blockPlanes + c * 8, 8, count, components[c]);
+    }
+    // write 4 bytes and advance by 3, the last pixel of the line is written separately to stay in bounds
+    const auto numWide = x + count == width ? count - 1 : count;
+    auto *out = rgb + x * 3;
+    for (std::size_t i = 0; i < numWide; i++) {
+      const std::uint8_t pixel[4] = {components[0][i], components[1][i], components[2][i], 0};
+      std::memcpy(out + i * 3, pixel, 4);
+    }
+    if (numWide < count) {
+      const std::uint8_t pixel[3] = {components[0][numWide], components[1][numWide], components[2][numWide]};
+      std::memcpy(out + numWide * 3, pixel, 3);
+    }
+  }
+}
+
+void toPlanar(const std::uint8_t *chunky, std::size_t width, int numPlanes, std::uint8_t *const *planes) {
+  // the transpose is its own inverse: pixel k in byte k gives plane p in byte 7 - p
+  for (std::size_t group = 0; group * 8 < width; group++) {
+    const auto count = std::min<std::size_t>(8, width - group * 8);
+    std::uint64_t x = 0;
+    for (std::size_t k = 0; k < count; k++) {
+      x |= static_cast<std::uint64_t>(chunky[group * 8 + k]) << (8 * k);
+    }
+    x = transpose(x);
+    for (auto p = 0; p < numPlanes; p++) {
+      planes[p][group] = static_cast<std::uint8_t>(x >> (8 * (7 - p)));
+    }
+  }
+}
+}// namespace Planar
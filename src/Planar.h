@@ -0,0 +1,25 @@
+#ifndef COLORCYCLING__PLANAR_H
+#define COLORCYCLING__PLANAR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* conversion of Amiga bitplanes, one bit per pixel with the leftmost pixel in the most significant bit,
+ * to chunky pixels and back */
+namespace Planar {
+/* bytes of a line of one plane, lines are a multiple of 16 bits */
+inline std::size_t getLineSize(std::size_t width) { return (width + 15) / 16 * 2; }
+
+/* combines width pixels of numPlanes (1 to 8) plane lines into one byte per pixel, plane p gives bit p
+ * and the missing planes are 0. Uses SSE2 (16 groups of 8 pixels per step) when available. */
+void toChunky(const std::uint8_t *const *planes, int numPlanes, std::size_t width, std::uint8_t *chunky);
+/* the portable version of toChunky: one 64-bit transpose per 8 pixels */
+void toChunkySwar(const std::uint8_t *const *planes, int numPlanes, std::size_t width, std::uint8_t *chunky);
+/* the inverse of toChunky: splits width chunky pixels into numPlanes (1 to 8) plane lines, bit p going to plane p.
+ * The bits after width in the last byte are 0, the bytes after it are left as they are. */
+void toPlanar(const std::uint8_t *chunky, std::size_t width, int numPlanes, std::uint8_t *const *planes);
+/* combines width pixels of 24 plane lines into packed RGB, planes 0 to 7 are red, 8 to 15 green and 16 to 23 blue */
+void toRgb(const std::uint8_t *const *planes, std::size_t width, std::uint8_t *rgb);
+}// namespace Planar
+
+#endif//COLORCYCLING__PLANAR_H
@@ -0,0 +1,262 @@
+#include "Renderer.h"
+#include "Trace.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+const char *vertexShaderSource = "#version 330 core\n"
+                                 "uniform mat4 xform;\n"
+                                 "layout (location = 0) in vec4 attr_vertex;\n"
+                                 "out vec2 uv;\n"
+                                 "void main()\n"
+                                 "{\n"
+                                 "   gl_Position = xform * attr_vertex;\n"
+                                 "   uv = attr_vertex.xy * vec2(0.5, -0.5) + 0.5;\n"
+                                 "}\0";
+const char *fragmentShaderSource = "#version 330 core\n"
+                                   "out vec4 FragColor;\n"
+                                   "in vec2 uv;\n"
+                                   "uniform sampler2D img_tex;\n"
+                                   "uniform sampler1D pal_tex;\n"
+                                   "uniform bool truecolor;\n"
+                                   "uniform float filled;\n"
+                                   "void main()\n"
+                                   "{\n"
+                                   "  if (uv.y > filled) {\n"
+                                   "    FragColor = vec4(0.3, 0.3, 0.3, 1.0);\n"
+                                   "    return;\n"
+                                   "  }\n"
+                                   "  vec3 texel = texture(img_tex, uv).xyz;\n"
+                                   "  vec3 color = truecolor ? texel : texture(pal_tex, texel.x).xyz;\n"
+                                   "  FragColor.xyz = color;\n"
+                                   "  FragColor.a = 1.0;\n"
+                                   "}\n\0";
+
+constexpr float vertices[] = {
+    1.0f, 1.0f, 0.0f, 0.0f,  // top right
+    1.0f, -1.0f, 0.0f, 0.0f, // bottom right
+    -1.0f, -1.0f, 0.0f, 0.0f,// bottom left
+    -1.0f, 1.0f, 0.0f, 0.0f  // top left
+};
+
+constexpr unsigned int indices[] = {
+    // note that we start from 0!
+    0, 1, 3,// first triangle
+    1, 2, 3 // second triangle
+};
+
+Renderer::Renderer() = default;
+
+Renderer::~Renderer() {
+  if (!m_shaderProgram)
+    return;
+  glDeleteTextures(1, &m_img_tex);
+  glDeleteTextures(1, &m_pal_tex);
+  glDeleteVertexArrays(1, &m_vao);
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteProgram(m_shaderProgram);
+}
+
+void Renderer::init() {
+  int vertexShader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
+  glCompileShader(vertexShader);
+  // check for shader compile errors
+  int success;
+  char infoLog[512];
+  glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
+    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
+              << infoLog << std::endl;
+  }
+  // fragment shader
+  int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
+  glCompileShader(fragmentShader);
+  // check for shader compile errors
+  glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+  if (!success) {
+    glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
+    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
+              << infoLog << std::endl;
+  }
+  // link shaders
+  m_shaderProgram = glCreateProgram();
+  glAttachShader(m_shaderProgram, vertexShader);
+  glAttachShader(m_shaderProgram, fragmentShader);
+  glLinkProgram(m_shaderProgram);
+  // check for linking errors
+  glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &success);
+  if (!success) {
+    glGetProgramInfoLog(m_shaderProgram, 512, nullptr, infoLog);
+    std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+              << infoLog << std::endl;
+  }
+  glDeleteShader(vertexShader);
+  glDeleteShader(fragmentShader);
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+  glGenBuffers(1, &m_ebo);
+  // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+  // position attribute
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(0);
+
+  glGenTextures(1, &m_pal_tex);
+  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+
+  glUseProgram(m_shaderProgram);
+  glUniform1i(glGetUniformLocation(m_shaderProgram, "img_tex"), 0);
+  glUniform1i(glGetUniformLocation(m_shaderProgram, "pal_tex"), 1);
+}
+
+void Renderer::setImage(const Ilbm &image) {
+  TRACE_SCOPE("Renderer::setImage");
+  // deep images are drawn from their RGB pixels, the others from their indices through the palette
+  const auto trueColor = image.isTrueColor();
+  const auto pixels = trueColor ? Span<const std::uint8_t>(image.rgb.data(), image.rgb.size()) : image.pixels();
+  beginImage(image.header.width, image.header.height, trueColor, image.palette.data());
+  if (pixels.size() >= image.stride() * m_imageHeight * (trueColor ? 3u : 1u))
+    uploadRows(pixels.data(), image.stride(), 0, m_imageHeight);
+}
+
+void Renderer::beginImage(int width, int height, bool trueColor, const std::uint8_t *palette) {
+  // a texture of the exact size of each image, its storage never changes
+  glDeleteTextures(1, &m_img_tex);
+  m_img_tex = 0;
+  m_imageWidth = width;
+  m_imageHeight = height;
+  m_trueColor = trueColor;
+  m_filledRows = 0;
+  if (m_imageWidth > 0 && m_imageHeight > 0) {
+    const auto internalFormat = trueColor ? GL_RGB8 : GL_R8;
+    glGenTextures(1, &m_img_tex);
+    glBindTexture(GL_TEXTURE_2D, m_img_tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (GLEW_ARB_texture_storage) {
+      glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, m_imageWidth, m_imageHeight);
+    } else {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_imageWidth, m_imageHeight, 0, trueColor ? GL_RGB : GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    }
+  }
+  glUseProgram(m_shaderProgram);
+  glUniform1i(glGetUniformLocation(m_shaderProgram, "truecolor"), trueColor);
+  glUniform1f(glGetUniformLocation(m_shaderProgram, "filled"), 0.f);
+  updateTransform();
+
+  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
+  glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB, 256, 0, GL_RGB, GL_UNSIGNED_BYTE, palette);
+}
+
+void Renderer::uploadRows(const std::uint8_t *pixels, std::size_t stride, int firstRow, int numRows) {
+  TRACE_SCOPE("Renderer::uploadRows");
+  if (!m_img_tex || numRows <= 0)
+    return;
+  const auto bytesPerPixel = m_trueColor ? 3u : 1u;
+  glBindTexture(GL_TEXTURE_2D, m_img_tex);
+  // rows are byte aligned and padded to an even width
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, m_imageWidth, numRows, m_trueColor ? GL_RGB : GL_RED, GL_UNSIGNED_BYTE,
+                  pixels + firstRow * stride * bytesPerPixel);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+  // the rows are uploaded from the top, the ones below aren't drawn yet
+  m_filledRows = std::max(m_filledRows, firstRow + numRows);
+  glUseProgram(m_shaderProgram);
+  glUniform1f(glGetUniformLocation(m_shaderProgram, "filled"), static_cast<float>(m_filledRows) / static_cast<float>(m_imageHeight));
+}
+
+void Renderer::uploadRect(const std::uint8_t *pixels, std::size_t stride, int x, int y, int width, int height) {
+  TRACE_SCOPE("Renderer::uploadRect");
+  if (!m_img_tex || width <= 0 || height <= 0)
+    return;
+  const auto bytesPerPixel = m_trueColor ? 3u : 1u;
+  glBindTexture(GL_TEXTURE_2D, m_img_tex);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, m_trueColor ? GL_RGB : GL_RED, GL_UNSIGNED_BYTE,
+                  pixels + (y * stride + x) * bytesPerPixel);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void Renderer::clearImage() {
+  glDeleteTextures(1, &m_img_tex);
+  m_img_tex = 0;
+  m_imageWidth = m_imageHeight = m_filledRows = 0;
+}
+
+void Renderer::updatePalette(const Ilbm &image) {
+  TRACE_SCOPE("Renderer::updatePalette");
+  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
+  glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGB, GL_UNSIGNED_BYTE, &image.palette[0]);
+}
+
+void Renderer::reshape(int x, int y) {
+  m_viewportWidth = x;
+  m_viewportHeight = y;
+  glViewport(0, 0, x, y);
+  updateTransform();
+}
+
+void Renderer::updateTransform() const {
+  if (m_viewportWidth <= 0 || m_viewportHeight <= 0 || m_imageWidth <= 0 || m_imageHeight <= 0)
+    return;
+
+  int loc;
+  float aspect = (float) m_viewportWidth / (float) m_viewportHeight;
+  float fbaspect = (float) m_imageWidth / (float) m_imageHeight;
+  float xform[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+  if (aspect > fbaspect) {
+    xform[0] = fbaspect / aspect;
+  } else if (fbaspect > aspect) {
+    xform[5] = aspect / fbaspect;
+  }
+
+  glUseProgram(m_shaderProgram);
+  if ((loc = glGetUniformLocation(m_shaderProgram, "xform")) >= 0) {
+    glUniformMatrix4fv(loc, 1, GL_FALSE, xform);
+  }
+
+  auto err = glGetError();
+  assert(err == GL_NO_ERROR);
+}
+
+void Renderer::draw() const {
+  glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  if (!m_img_tex)
+    return;
+
+  // bind textures on corresponding texture units
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_img_tex);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_1D, m_pal_tex);
+
+  // draw our first triangle
+  glUseProgram(m_shaderProgram);
+  glBindVertexArray(m_vao);// seeing as we only have a single m_vao there's no need to bind it every time, but we'll do so to keep things a bit more organized
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+}
@@ -0,0 +1,46 @@
+#ifndef COLORCYCLING__RENDERER_H
+#define COLORCYCLING__RENDERER_H
+
+#include "Ilbm.h"
+
+/* draws an indexed image through its palette, or a deep image from its RGB pixels, with OpenGL,
+ * needs a current GL context */
+class Renderer {
+public:
+  Renderer();
+  ~Renderer();
+
+  void init();
+  /* creates a texture of the size of a new image and uploads its indices (or RGB pixels) and its palette */
+  void setImage(const Ilbm &image);
+  /* creates the texture of an image whose rows are uploaded later with uploadRows, and uploads its palette */
+  void beginImage(int width, int height, bool trueColor, const std::uint8_t *palette);
+  /* uploads numRows rows from firstRow, pixels is the whole image with stride pixels per row. The rows
+   * below the ones uploaded so far are drawn empty. */
+  void uploadRows(const std::uint8_t *pixels, std::size_t stride, int firstRow, int numRows);
+  /* uploads a rect of an image whose rows are all uploaded already, pixels is the whole image with stride
+   * pixels per row */
+  void uploadRect(const std::uint8_t *pixels, std::size_t stride, int x, int y, int width, int height);
+  /* draws nothing until the next image */
+  void clearImage();
+  /* uploads the palette after it has been cycled */
+  void updatePalette(const Ilbm &image);
+  /* the image keeps its aspect ratio in a viewport of x by y pixels */
+  void reshape(int x, int y);
+  void draw() const;
+
+private:
+  void updateTransform() const;
+
+private:
+  int m_shaderProgram{0};
+  unsigned int m_vao{0};
+  unsigned int m_vbo{0}, m_ebo{0};
+  unsigned int m_img_tex{0}, m_pal_tex{0};
+  int m_imageWidth{0}, m_imageHeight{0};
+  bool m_trueColor{false};
+  int m_filledRows{0};
+  int m_viewportWidth{0}, m_viewportHeight{0};
+};
+
+#endif//COLORCYCLING__RENDERER_H
@@ -0,0 +1,237 @@
+#include "SceneCache.h"
+#include "IffReader.h"
+#include "MappedFile.h"
+#include "SceneFile.h"
+#include "Trace.h"
+#include "Util.h"
+#include "ViewModes.h"
+#include <sstream>
+#include <vector>
+
+namespace {
+/* the keys of an IFF file, false when it isn't one the cache can key */
+bool getKeys(Span<const std::uint8_t> data, std::uint64_t &contentKey, std::uint64_t &bodyKey) {
+  try {
+    IffReader reader(data);
+    const auto formType = reader.getFormType();
+    auto content = Util::hashContent(formType.data(), formType.size());
+    Span<const std::uint8_t> header, body;
+    auto hasBody = false;
+    IffChunk chunk;
+    while (reader.next(chunk)) {
+      // the first body is the one the loader decodes
+      if (!hasBody && (chunk.is("BODY") || (chunk.is("ABIT") && formType == "ACBM"))) {
+        hasBody = true;
+        body = chunk.data;
+        continue;
+      }
+      if (chunk.is("BMHD") && !hasBody)
+        header = chunk.data;
+      content = Util::hashContent(chunk.id, 4, content);
+      content = Util::hashContent(chunk.data.data(), chunk.data.size(), content);
+    }
+    bodyKey = 0;
+    if (hasBody) {
+      bodyKey = Util::hashContent(formType.data(), formType.size());
+      bodyKey = Util::hashContent(header.data(), header.size(), bodyKey);
+      bodyKey = Util::hashContent(body.data(), body.size(), bodyKey);
+    }
+    contentKey = Util::hashContent(&bodyKey, sizeof(bodyKey), content);
+    return true;
+  } catch (const std::runtime_error &) {
+    // the loader reports the error
+    return false;
+  }
+}
+
+void decode(const std::string &path, Ilbm &image, IlbmLoader::Progress *progress) {
+  if (progress) {
+    IlbmLoader::load(path, image, *progress);
+  } else {
+    image = std::move(*IlbmLoader::load(path));
+  }
+}
+}// namespace
+
+SceneCache::SceneCache(std::size_t budget) : m_budget(budget) {}
+
+std::unique_ptr<Ilbm> SceneCache::load(const std::string &path) {
+  auto image = std::make_unique<Ilbm>();
+  load(path, *image, nullptr);
+  return image;
+}
+
+void SceneCache::load(const std::string &path, Ilbm &image, IlbmLoader::Progress &progress) {
+  load(path, image, &progress);
+}
+
+void SceneCache::load(const std::string &path, Ilbm &image, IlbmLoader::Progress *progress) {
+  TRACE_SCOPE("SceneCache::load");
+  std::error_code error;
+  const auto size = std::filesystem::file_size(path, error);
+  const auto time = error ? std::filesystem::file_time_type{} : std::filesystem::last_write_time(path, error);
+  Keys keys;
+  auto known = false;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto file = m_files.find(path);
+    if (!error && file != m_files.end() && file->second.size == size && file->second.time == time) {
+      keys = file->second.keys;
+      known = true;
+      if (find(keys.content, image)) {
+        m_stats.numHits++;
+        return;
+      }
+    }
+  }
+
+  auto file = std::make_shared<const MappedFile>(path);
+  const auto data = file->getData();
+  if (!known) {
+    TRACE_SCOPE("hash");
+    // the .ccyc scenes are mapped without decoding already
+    if (SceneFile::isSceneFile(data) || !getKeys(data, keys.content, keys.body)) {
+      decode(path, image, progress);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!error)
+      m_files[path] = {size, time, keys};
+    if (find(keys.content, image)) {
+      m_stats.numHits++;
+      return;
+    }
+  }
+
+  Indices indices{};
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = keys.body ? m_indices.find(keys.body) : m_indices.end();
+    if (found != m_indices.end())
+      indices = found->second;
+  }
+  if (indices.storage) {
+    // another palette or other ranges on indices decoded already
+    std::unique_ptr<Ilbm> loaded;
+    try {
+      loaded = IlbmLoader::loadWithoutBody(data);
+    } catch (const std::runtime_error &e) {
+      std::ostringstream ss;
+      ss << path << ": " << e.what();
+      throw std::runtime_error(ss.str());
+    }
+    image = std::move(*loaded);
+    image.mappedImage = indices.data;
+    image.storage = indices.storage;
+    // the colors of a HAM image depend on its palette
+    if (image.isHam())
+      ViewModes::resolveHam(image);
+  } else {
+    decode(path, image, progress);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (indices.storage) {
+    m_stats.numBodyHits++;
+  } else {
+    m_stats.numMisses++;
+  }
+  // an uncompressed body decoded is a view of the whole file
+  insert(keys, image, indices.storage ? indices.size : data.size());
+}
+
+bool SceneCache::find(std::uint64_t key, Ilbm &image) {
+  auto found = m_sceneIndex.find(key);
+  if (found == m_sceneIndex.end())
+    return false;
+  m_scenes.splice(m_scenes.begin(), m_scenes, found->second);
+  image = *found->second->image;
+  return true;
+}
+
+void SceneCache::insert(const Keys &keys, Ilbm &image, std::size_t viewSize) {
+  if (m_sceneIndex.count(keys.content))
+    return;
+
+  // the bytes the indices keep alive: their own buffer, or what they are a view of
+  auto indicesSize = image.mappedImage.empty() ? 0 : viewSize;
+  // the decoded indices are shared by the image and the cache from now on, they don't move
+  if (!image.image.empty()) {
+    auto buffer = std::make_shared<const std::vector<std::uint8_t>>(std::move(image.image));
+    image.image.clear();
+    image.mappedImage = {buffer->data(), buffer->size()};
+    image.storage = std::move(buffer);
+    indicesSize = image.mappedImage.size();
+  }
+  const auto shared = keys.body && !image.mappedImage.empty();
+  auto indices = shared ? m_indices.find(keys.body) : m_indices.end();
+  // the shared indices are charged once, with the first scene using them, the other indices with their scene
+  if (indices != m_indices.end())
+    indicesSize = 0;
+  const auto size = sizeof(Ilbm) + image.rgb.size() + (shared ? 0 : indicesSize);
+  if (size + (shared ? indicesSize : 0) > m_budget)
+    return;
+
+  auto cached = std::make_shared<Ilbm>(image);
+  if (shared && indices == m_indices.end()) {
+    m_indices.emplace(keys.body, Indices{image.mappedImage, image.storage, indicesSize, 1});
+  } else if (shared) {
+    // decoded by another miss meanwhile: the indices are charged once, the cached scene is a view of the cached
+    // ones while image keeps its own, which a progress may still read
+    cached->mappedImage = indices->second.data;
+    cached->storage = indices->second.storage;
+    indices->second.numScenes++;
+  }
+  m_scenes.push_front({shared ? keys : Keys{keys.content, 0}, std::move(cached), size});
+  m_sceneIndex[keys.content] = m_scenes.begin();
+  m_size += size + (shared ? indicesSize : 0);
+  evict();
+}
+
+void SceneCache::evict() {
+  while (m_size > m_budget && !m_scenes.empty()) {
+    const auto &scene = m_scenes.back();
+    m_size -= scene.size;
+    auto indices = scene.keys.body ? m_indices.find(scene.keys.body) : m_indices.end();
+    if (indices != m_indices.end() && --indices->second.numScenes == 0) {
+      m_size -= indices->second.size;
+      m_indices.erase(indices);
+    }
+    m_sceneIndex.erase(scene.keys.content);
+    m_scenes.pop_back();
+  }
+}
+
+void SceneCache::setBudget(std::size_t budget) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budget = budget;
+  evict();
+}
+
+void SceneCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_scenes.clear();
+  m_sceneIndex.clear();
+  m_indices.clear();
+  m_size = 0;
+}
+
+std::size_t SceneCache::getBudget() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budget;
+}
+
+std::size_t SceneCache::getSize() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size;
+}
+
+std::size_t SceneCache::getNumScenes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_scenes.size();
+}
+
+SceneCache::Stats SceneCache::getStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
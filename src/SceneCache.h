@@ -0,0 +1,91 @@
+#ifndef COLORCYCLING__SCENECACHE_H
+#define COLORCYCLING__SCENECACHE_H
+
+#include "Ilbm.h"
+#include "IlbmLoader.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/* LRU cache of the decoded images keyed by the hash of their file content, within a budget of bytes.
+ * Images with the same BMHD and BODY (variants with another palette or other ranges) share their color
+ * indices, which are decoded once. The loads can run on several threads, they decode outside the lock. */
+class SceneCache {
+public:
+  static constexpr std::size_t DefaultBudget = 256u << 20;
+
+  struct Stats {
+    std::size_t numHits{0};      /* images found in the cache */
+    std::size_t numBodyHits{0};  /* images whose indices were found in the cache, only their other chunks were parsed */
+    std::size_t numMisses{0};    /* images decoded */
+  };
+
+  explicit SceneCache(std::size_t budget = DefaultBudget);
+
+  /* loads path like IlbmLoader::load, from the cache when the same content was loaded before */
+  std::unique_ptr<Ilbm> load(const std::string &path);
+  /* loads path into an empty image, progress only follows the images decoded, the other ones are complete at once */
+  void load(const std::string &path, Ilbm &image, IlbmLoader::Progress &progress);
+
+  /* evicts the least recently used images until the cache fits */
+  void setBudget(std::size_t budget);
+  void clear();
+
+  [[nodiscard]] std::size_t getBudget() const;
+  /* bytes of the cached images, the shared indices counted once */
+  [[nodiscard]] std::size_t getSize() const;
+  [[nodiscard]] std::size_t getNumScenes() const;
+  [[nodiscard]] Stats getStats() const;
+
+private:
+  struct Keys {
+    std::uint64_t content{0}; /* the whole file */
+    std::uint64_t body{0};    /* the form type, the BMHD and the BODY, 0 without body */
+  };
+
+  /* the keys of a file as long as its size and time don't change, to skip hashing it again */
+  struct FileKeys {
+    std::uintmax_t size;
+    std::filesystem::file_time_type time;
+    Keys keys;
+  };
+
+  struct Scene {
+    Keys keys;
+    std::shared_ptr<const Ilbm> image; /* its indices are a view of the shared ones */
+    std::size_t size;                  /* with its indices unless they are shared */
+  };
+
+  struct Indices {
+    Span<const std::uint8_t> data;
+    std::shared_ptr<const void> storage;
+    std::size_t size; /* bytes charged for them: their buffer or the whole file they are a view of */
+    std::size_t numScenes;
+  };
+
+  void load(const std::string &path, Ilbm &image, IlbmLoader::Progress *progress);
+  /* copies the image cached for key into image and makes it the most recently used, the lock is held */
+  bool find(std::uint64_t key, Ilbm &image);
+  /* moves the decoded indices of image into a shared buffer and caches it, viewSize is the size of what the
+   * indices keep alive when they are a view */
+  void insert(const Keys &keys, Ilbm &image, std::size_t viewSize);
+  /* the lock is held */
+  void evict();
+
+private:
+  mutable std::mutex m_mutex;
+  std::size_t m_budget;
+  std::size_t m_size{0};
+  Stats m_stats;
+  std::list<Scene> m_scenes; /* the most recently used first */
+  std::unordered_map<std::uint64_t, std::list<Scene>::iterator> m_sceneIndex;
+  std::unordered_map<std::uint64_t, Indices> m_indices;
+  std::unordered_map<std::string, FileKeys> m_files;
+};
+
+#endif//COLORCYCLING__SCENECACHE_H
@@ -0,0 +1,250 @@
+#include "SceneFile.h"
+#include "ColorCycler.h"
+#include "ViewModes.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace SceneFile {
+namespace {
+constexpr char Magic[4] = {'C', 'C', 'Y', 'C'};
+constexpr std::size_t HeaderSize = 64;
+constexpr std::size_t PaletteSize = 256 * 3;
+constexpr std::size_t RangeSize = 8;
+/* the ranges of version 1 scenes end with their period */
+constexpr std::size_t RangeSizeV1 = 12;
+/* header flags */
+constexpr std::uint8_t FlagTrueColor = 1;
+constexpr std::uint8_t FlagBakedBlend = 2;
+
+void putU16(std::uint8_t *out, std::uint16_t value) {
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void putU32(std::uint8_t *out, std::uint32_t value) {
+  putU16(out, static_cast<std::uint16_t>(value));
+  putU16(out + 2, static_cast<std::uint16_t>(value >> 16));
+}
+
+std::uint16_t getU16(const std::uint8_t *data) {
+  return static_cast<std::uint16_t>(data[0] | data[1] << 8);
+}
+
+std::uint32_t getU32(const std::uint8_t *data) {
+  return getU16(data) | static_cast<std::uint32_t>(getU16(data + 2)) << 16;
+}
+
+std::size_t alignUp(std::size_t offset, std::size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+[[noreturn]] void fail(const char *what) {
+  std::ostringstream ss;
+  ss << "Error when reading the .ccyc scene: " << what;
+  throw std::runtime_error(ss.str());
+}
+
+/* the part [offset, offset + size) of data, which must be in bounds */
+Span<const std::uint8_t> getPart(Span<const std::uint8_t> data, std::size_t offset, std::size_t size, const char *name) {
+  if (offset > data.size() || size > data.size() - offset) {
+    std::ostringstream ss;
+    ss << "the " << name << " run past the end of the file";
+    fail(ss.str().c_str());
+  }
+  return data.subspan(offset, size);
+}
+}// namespace
+
+std::vector<Range> getRanges(const Ilbm &image) {
+  std::vector<Range> ranges;
+  for (auto i = 0; i < image.numCycles; i++) {
+    const auto &cycle = image.cycles[i];
+    if (!cycle.rate)
+      continue;
+    Range range;
+    range.low = cycle.low;
+    range.high = std::max(cycle.low, cycle.high);
+    range.mode = cycle.flags;
+    range.rate = cycle.rate;
+    ranges.push_back(range);
+  }
+  return ranges;
+}
+
+std::vector<std::uint8_t> write(const Ilbm &image, std::size_t numBakedTicks, bool bakedBlend) {
+  const auto &header = image.header;
+  // the HAM images are stored as their indices, their colors depend on the cycled palette
+  const auto trueColor = image.isTrueColor() && !image.isHam();
+  const auto pixels = trueColor ? Span<const std::uint8_t>(image.rgb.data(), image.rgb.size()) : image.pixels();
+  const auto pixelsSize = image.stride() * header.height * (trueColor ? 3 : 1);
+  if (pixels.size() < pixelsSize)
+    throw std::runtime_error("Error when writing the .ccyc scene: the image has no pixels");
+  // deep images have no palette to cycle
+  const auto ranges = trueColor ? std::vector<Range>{} : getRanges(image);
+  if (trueColor || image.isHam())
+    numBakedTicks = 0;
+
+  const auto rangesOffset = HeaderSize + PaletteSize;
+  const auto pixelsOffset = alignUp(rangesOffset + ranges.size() * RangeSize, PixelAlignment);
+  const auto bakedOffset = alignUp(pixelsOffset + pixelsSize, 64);
+  const auto size = numBakedTicks ? bakedOffset + numBakedTicks * PaletteSize : pixelsOffset + pixelsSize;
+  if (size > std::numeric_limits<std::uint32_t>::max())
+    throw std::runtime_error("Error when writing the .ccyc scene: larger than 4 GB");
+
+  std::vector<std::uint8_t> out(size, 0);
+  auto *h = out.data();
+  std::memcpy(h, Magic, 4);
+  putU16(h + 4, Version);
+  putU16(h + 6, HeaderSize);
+  putU16(h + 8, header.width);
+  putU16(h + 10, header.height);
+  putU32(h + 12, static_cast<std::uint32_t>(image.stride()));
+  h[16] = static_cast<std::uint8_t>((trueColor ? FlagTrueColor : 0) | (bakedBlend ? FlagBakedBlend : 0));
+  h[17] = static_cast<std::uint8_t>(ranges.size());
+  putU16(h + 18, header.transparent_color);
+  h[20] = header.num_planes;
+  h[21] = header.x_aspect;
+  h[22] = header.y_aspect;
+  h[23] = header.compression;
+  putU16(h + 24, static_cast<std::uint16_t>(header.x));
+  putU16(h + 26, static_cast<std::uint16_t>(header.y));
+  putU16(h + 28, static_cast<std::uint16_t>(header.page_width));
+  putU16(h + 30, static_cast<std::uint16_t>(header.page_height));
+  putU32(h + 32, HeaderSize);
+  putU32(h + 36, static_cast<std::uint32_t>(rangesOffset));
+  putU32(h + 40, static_cast<std::uint32_t>(pixelsOffset));
+  putU32(h + 44, static_cast<std::uint32_t>(pixelsSize));
+  putU32(h + 48, static_cast<std::uint32_t>(numBakedTicks ? bakedOffset : 0));
+  putU32(h + 52, static_cast<std::uint32_t>(numBakedTicks));
+  putU32(h + 56, image.viewMode);
+
+  std::memcpy(out.data() + HeaderSize, image.palette.data(), PaletteSize);
+  for (std::size_t i = 0; i < ranges.size(); i++) {
+    auto *r = out.data() + rangesOffset + i * RangeSize;
+    r[0] = ranges[i].low;
+    r[1] = ranges[i].high;
+    putU16(r + 2, static_cast<std::uint16_t>(ranges[i].mode));
+    putU16(r + 4, static_cast<std::uint16_t>(ranges[i].rate));
+  }
+  std::memcpy(out.data() + pixelsOffset, pixels.data(), pixelsSize);
+
+  if (numBakedTicks) {
+    // the palettes the reference cycler produces, on a copy of the ranges as they are stored
+    Ilbm cycled{};
+    cycled.palette = image.palette;
+    cycled.numCycles = static_cast<std::uint8_t>(ranges.size());
+    for (std::size_t i = 0; i < ranges.size(); i++) {
+      cycled.cycles[i] = {0, ranges[i].rate, ranges[i].mode, ranges[i].low, ranges[i].high};
+    }
+    ColorCycler cycler;
+    cycler.setBasePalette(image.palette);
+    cycler.setBlend(bakedBlend);
+    for (std::size_t tick = 0; tick < numBakedTicks; tick++) {
+      cycler.step(cycled);
+      std::memcpy(out.data() + bakedOffset + tick * PaletteSize, cycled.palette.data(), PaletteSize);
+    }
+  }
+  return out;
+}
+
+void save(const Ilbm &image, const std::string &path, std::size_t numBakedTicks, bool bakedBlend) {
+  auto data = write(image, numBakedTicks, bakedBlend);
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+  if (!os) {
+    std::ostringstream ss;
+    ss << "Error when writing " << path;
+    throw std::runtime_error(ss.str());
+  }
+}
+
+bool isSceneFile(Span<const std::uint8_t> data) {
+  return data.size() >= 4 && std::memcmp(data.data(), Magic, 4) == 0;
+}
+
+Scene parse(Span<const std::uint8_t> data) {
+  if (!isSceneFile(data) || data.size() < HeaderSize)
+    fail("no .ccyc header");
+  const auto *h = data.data();
+  // version 1 has no view mode nor compression, their bytes are 0
+  const auto version = getU16(h + 4);
+  if (version < 1 || version > Version) {
+    std::ostringstream ss;
+    ss << "version " << version << " is not supported";
+    fail(ss.str().c_str());
+  }
+  if (getU16(h + 6) < HeaderSize)
+    fail("the header is too short");
+
+  Scene scene;
+  auto &header = scene.header;
+  header.width = getU16(h + 8);
+  header.height = getU16(h + 10);
+  const auto stride = getU32(h + 12);
+  scene.trueColor = (h[16] & FlagTrueColor) != 0;
+  scene.bakedBlend = (h[16] & FlagBakedBlend) != 0;
+  const auto numRanges = h[17];
+  header.transparent_color = getU16(h + 18);
+  header.num_planes = h[20];
+  header.x_aspect = h[21];
+  header.y_aspect = h[22];
+  header.compression = h[23];
+  header.x = static_cast<short>(getU16(h + 24));
+  header.y = static_cast<short>(getU16(h + 26));
+  header.page_width = static_cast<short>(getU16(h + 28));
+  header.page_height = static_cast<short>(getU16(h + 30));
+  // the rows have the stride of the decoded images
+  if (stride != ((header.width + 1u) & ~1u))
+    fail("the stride doesn't match the width");
+
+  scene.palette = getPart(data, getU32(h + 32), PaletteSize, "palette");
+  const auto rangeSize = version == 1 ? RangeSizeV1 : RangeSize;
+  const auto ranges = getPart(data, getU32(h + 36), numRanges * rangeSize, "ranges");
+  for (auto i = 0; i < numRanges; i++) {
+    const auto *r = ranges.data() + i * rangeSize;
+    Range range;
+    range.low = r[0];
+    range.high = r[1];
+    range.mode = static_cast<std::int16_t>(getU16(r + 2));
+    range.rate = static_cast<std::int16_t>(getU16(r + 4));
+    if (range.high < range.low || !range.rate)
+      fail("a range isn't normalized");
+    scene.ranges.push_back(range);
+  }
+
+  const auto pixelsSize = static_cast<std::size_t>(stride) * header.height * (scene.trueColor ? 3 : 1);
+  if (getU32(h + 44) < pixelsSize)
+    fail("the pixels are too short");
+  scene.pixels = getPart(data, getU32(h + 40), pixelsSize, "pixels");
+  scene.numBakedTicks = getU32(h + 52);
+  scene.viewMode = getU32(h + 56);
+  if (scene.numBakedTicks)
+    scene.bakedPalettes = getPart(data, getU32(h + 48), scene.numBakedTicks * PaletteSize, "baked palettes");
+  return scene;
+}
+
+void toIlbm(const Scene &scene, const std::shared_ptr<const void> &storage, Ilbm &image) {
+  image.header = scene.header;
+  std::memcpy(image.palette.data(), scene.palette.data(), PaletteSize);
+  // at most 255 ranges are stored, like the CRNG chunks the loader keeps
+  image.numCycles = static_cast<std::uint8_t>(scene.ranges.size());
+  for (std::size_t i = 0; i < scene.ranges.size(); i++) {
+    const auto &range = scene.ranges[i];
+    image.cycles[i] = {0, range.rate, range.mode, range.low, range.high};
+  }
+  image.viewMode = scene.trueColor ? 0 : scene.viewMode;
+  if (scene.trueColor) {
+    image.rgb.assign(scene.pixels.begin(), scene.pixels.end());
+  } else {
+    image.mappedImage = scene.pixels;
+    image.storage = storage;
+    image.bakedPalettes = scene.bakedPalettes;
+    image.bakedBlend = scene.bakedBlend;
+    if (image.isHam())
+      ViewModes::resolveHam(image);
+  }
+}
+}// namespace SceneFile
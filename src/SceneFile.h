@@ -0,0 +1,70 @@
+#ifndef COLORCYCLING__SCENEFILE_H
+#define COLORCYCLING__SCENEFILE_H
+
+#include "Ilbm.h"
+#include "Span.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* .ccyc scenes: an image already decoded, read in place from a mapped file. All the integers are little-endian.
+ *
+ *   header (64 bytes)   "CCYC", version, header size, the BMHD fields, the offsets and sizes below, the CAMG
+ *                       view mode and the compression of the image the scene was made from (version 2)
+ *   palette             256 RGB colors
+ *   ranges              the cycling ranges, 8 bytes each: low, high, mode (u16), rate (u16), 0 (u16), followed by
+ *                       an unused period (f32) in version 1
+ *   pixels              at a multiple of PixelAlignment, stride() indices (or RGB pixels for deep images) per row,
+ *                       the indices of the HAM images, resolved again when they are read
+ *   baked palettes      optional, the palettes of the first ticks of the cycling, which ColorCycler copies instead
+ *                       of cycling them again
+ */
+namespace SceneFile {
+constexpr std::uint16_t Version = 2;
+/* the pixels start on a page, ready to be handed to a texture upload from the mapping */
+constexpr std::size_t PixelAlignment = 4096;
+
+/* a cycling range of a scene, low <= high and rate isn't 0 */
+struct Range {
+  std::uint8_t low{0};
+  std::uint8_t high{0};
+  std::int16_t mode{0};
+  std::int16_t rate{0};
+};
+
+/* a scene read from a .ccyc file, the spans point into the file */
+struct Scene {
+  BitmapHeader header{};
+  bool trueColor{false};
+  std::uint32_t viewMode{0}; /* CAMG view mode, 0 in version 1 scenes */
+  Span<const std::uint8_t> palette;
+  std::vector<Range> ranges;
+  Span<const std::uint8_t> pixels;
+  /* numBakedTicks palettes of 256 RGB colors, the one of tick t cycled t + 1 times from the base palette at speed 1 */
+  Span<const std::uint8_t> bakedPalettes;
+  std::size_t numBakedTicks{0};
+  bool bakedBlend{true};
+};
+
+/* the CRNG ranges of an image as they are stored: the ranges with a rate of 0, which never cycle, are
+ * dropped and a range whose high index is below its low one covers its low index only */
+std::vector<Range> getRanges(const Ilbm &image);
+
+/* serializes an image, with the palettes of its first numBakedTicks ticks cycled with or without blend. The
+ * deep images and the HAM ones, whose colors aren't the palette, have no baked palette. */
+std::vector<std::uint8_t> write(const Ilbm &image, std::size_t numBakedTicks = 0, bool bakedBlend = true);
+/* writes an image to a file, throws std::runtime_error on failure */
+void save(const Ilbm &image, const std::string &path, std::size_t numBakedTicks = 0, bool bakedBlend = true);
+
+/* true when data starts with the .ccyc signature */
+bool isSceneFile(Span<const std::uint8_t> data);
+/* checks the header and the bounds of every part, throws std::runtime_error when data isn't a valid scene */
+Scene parse(Span<const std::uint8_t> data);
+/* fills image from a scene: the indices and the baked palettes are views of the file that storage keeps alive,
+ * the RGB pixels of the deep images are copied and the ones of the HAM images resolved from the indices */
+void toIlbm(const Scene &scene, const std::shared_ptr<const void> &storage, Ilbm &image);
+}// namespace SceneFile
+
+#endif//COLORCYCLING__SCENEFILE_H
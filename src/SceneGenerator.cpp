@@ -0,0 +1,84 @@
+#include "SceneGenerator.h"
+#include "ColorCycler.h"
+#include <algorithm>
+
+namespace SceneGenerator {
+namespace {
+/* splitmix64: unlike the standard distributions its output doesn't depend on the standard library */
+class Random {
+public:
+  explicit Random(std::uint64_t seed) : m_state(seed) {}
+
+  std::uint64_t next() {
+    auto z = (m_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /* uniform in [0, bound) */
+  std::uint32_t below(std::uint32_t bound) {
+    return static_cast<std::uint32_t>(((next() >> 32) * bound) >> 32);
+  }
+
+  /* uniform in [0, 1) */
+  float unit() {
+    return static_cast<float>(next() >> 40) / static_cast<float>(1 << 24);
+  }
+
+private:
+  std::uint64_t m_state;
+};
+}// namespace
+
+std::unique_ptr<Ilbm> generate(const SceneParameters &parameters) {
+  Random random(parameters.seed);
+  auto image = std::make_unique<Ilbm>();
+  auto &header = image->header;
+  header = {};
+  header.width = parameters.width;
+  header.height = parameters.height;
+  header.num_planes = 8;
+  header.compression = parameters.compress ? 1 : 0;
+  header.x_aspect = header.y_aspect = 1;
+  header.page_width = static_cast<short>(header.width);
+  header.page_height = static_cast<short>(header.height);
+
+  for (auto &component : image->palette) {
+    component = static_cast<std::uint8_t>(random.below(256));
+  }
+
+  const auto numPixels = image->stride() * header.height;
+  image->image.resize(numPixels);
+  const auto runLength = static_cast<std::uint32_t>(std::max(1, parameters.runLength));
+  std::size_t pos = 0;
+  while (pos < numPixels) {
+    // segments of runLength pixels on average, each one either a run of a single color or noise
+    auto length = std::min<std::size_t>(1 + random.below(runLength * 2), numPixels - pos);
+    if (random.unit() < parameters.runFraction) {
+      std::fill_n(image->image.begin() + static_cast<std::ptrdiff_t>(pos), length, static_cast<std::uint8_t>(random.below(256)));
+    } else {
+      for (std::size_t i = 0; i < length; i++) {
+        image->image[pos + i] = static_cast<std::uint8_t>(random.below(256));
+      }
+    }
+    pos += length;
+  }
+
+  static const int allModes[] = {CYCLE_NORMAL, CYCLE_REVERSE, CYCLE_PINGPONG, CYCLE_SINE, CYCLE_SINE_HALF};
+  const auto rangeSize = std::clamp(parameters.rangeSize, 2, 256);
+  const auto numCycles = std::clamp(parameters.numCycles, 0, 255);
+  for (auto i = 0; i < numCycles; i++) {
+    auto &cycle = image->cycles[i];
+    auto mode = parameters.modes.empty() ? allModes[i % 5] : parameters.modes[i % parameters.modes.size()];
+    // ranges are laid out one after the other and wrap around the palette
+    auto low = (i * rangeSize) % (257 - rangeSize);
+    cycle.rate = static_cast<std::int16_t>(1024 + random.below(16384 - 1024 + 1));
+    cycle.flags = static_cast<std::int16_t>(mode);
+    cycle.low = static_cast<std::uint8_t>(low);
+    cycle.high = static_cast<std::uint8_t>(low + rangeSize - 1);
+  }
+  image->numCycles = static_cast<std::uint8_t>(numCycles);
+  return image;
+}
+}// namespace SceneGenerator
@@ -0,0 +1,26 @@
+#ifndef COLORCYCLING__SCENEGENERATOR_H
+#define COLORCYCLING__SCENEGENERATOR_H
+
+#include "Ilbm.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* parameters of a synthetic scene, the same parameters always give the same scene */
+struct SceneParameters {
+  std::uint16_t width{640};
+  std::uint16_t height{480};
+  std::uint32_t seed{1};
+  float runFraction{0.5f}; /* share of the pixels in runs, the others are noise (literal-heavy ByteRun1) */
+  int runLength{32};       /* mean length of a run */
+  int numCycles{4};        /* number of CRNG ranges */
+  int rangeSize{16};       /* number of colors in a range */
+  std::vector<int> modes;  /* cycling modes given in turn to the ranges, all of them when empty */
+  bool compress{true};
+};
+
+namespace SceneGenerator {
+std::unique_ptr<Ilbm> generate(const SceneParameters &parameters);
+}// namespace SceneGenerator
+
+#endif//COLORCYCLING__SCENEGENERATOR_H
@@ -0,0 +1,275 @@
+#include "SceneIndex.h"
+#include "IffReader.h"
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include "SceneFile.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace SceneIndex {
+namespace {
+constexpr char Magic[4] = {'C', 'C', 'I', 'X'};
+constexpr std::size_t HeaderSize = 16;
+constexpr std::size_t EntrySize = 40;
+/* files read by a task of build, small enough for the threads to stay busy until the end */
+constexpr std::size_t BuildGrain = 8;
+
+void putU16(std::uint8_t *out, std::uint16_t value) {
+  out[0] = static_cast<std::uint8_t>(value);
+  out[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void putU32(std::uint8_t *out, std::uint32_t value) {
+  putU16(out, static_cast<std::uint16_t>(value));
+  putU16(out + 2, static_cast<std::uint16_t>(value >> 16));
+}
+
+void putU64(std::uint8_t *out, std::uint64_t value) {
+  putU32(out, static_cast<std::uint32_t>(value));
+  putU32(out + 4, static_cast<std::uint32_t>(value >> 32));
+}
+
+std::uint16_t getU16(const std::uint8_t *data) {
+  return static_cast<std::uint16_t>(data[0] | data[1] << 8);
+}
+
+std::uint32_t getU32(const std::uint8_t *data) {
+  return getU16(data) | static_cast<std::uint32_t>(getU16(data + 2)) << 16;
+}
+
+std::uint64_t getU64(const std::uint8_t *data) {
+  return getU32(data) | static_cast<std::uint64_t>(getU32(data + 4)) << 32;
+}
+
+[[noreturn]] void fail(const std::string &path, const char *what) {
+  std::ostringstream ss;
+  ss << "Error when reading " << path << ": " << what;
+  throw std::runtime_error(ss.str());
+}
+
+std::int64_t getTime(const std::string &path, std::error_code &error) {
+  return static_cast<std::int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+}
+}// namespace
+
+Entry read(const std::string &path) {
+  TRACE_SCOPE("SceneIndex::read");
+  Entry entry;
+  entry.path = path;
+  std::error_code error;
+  entry.size = std::filesystem::file_size(path, error);
+  if (!error)
+    entry.time = getTime(path, error);
+  std::ifstream is(path, std::ios::binary);
+  if (error || !is) {
+    std::ostringstream ss;
+    ss << "Error when opening " << path;
+    throw std::runtime_error(ss.str());
+  }
+
+  // the file is read from its start, in blocks twice as large each time the body isn't reached yet
+  std::vector<std::uint8_t> data;
+  const auto readUpTo = [&](std::size_t size) {
+    size = static_cast<std::size_t>(std::min<std::uint64_t>(std::max(size, data.size() * 2), entry.size));
+    if (size <= data.size())
+      return;
+    const auto offset = data.size();
+    data.resize(size);
+    is.read(reinterpret_cast<char *>(data.data() + offset), static_cast<std::streamsize>(size - offset));
+    if (static_cast<std::size_t>(is.gcount()) != size - offset)
+      fail(path, "the file is shorter than its size");
+  };
+  readUpTo(ReadSize);
+  if (data.size() < 12 || std::memcmp(data.data(), "FORM", 4) != 0)
+    fail(path, "not an IFF image");
+  std::memcpy(entry.formType, data.data() + 8, 4);
+
+  // an ANIM is indexed by the chunks of its first frame, the FORM starting at start
+  std::size_t start = 0, offset = 12;
+  for (;;) {
+    if (offset + 8 > data.size())
+      readUpTo(offset + 8);
+    if (offset + 8 > data.size())
+      break;
+    const auto *id = data.data() + offset;
+    if (std::memcmp(id, "BODY", 4) == 0 || (std::memcmp(id, "ABIT", 4) == 0 && std::memcmp(entry.formType, "ACBM", 4) == 0))
+      break;
+    if (std::memcmp(id, "FORM", 4) == 0 && start == 0 && std::memcmp(entry.formType, "ANIM", 4) == 0) {
+      start = offset;
+      offset += 12;
+      continue;
+    }
+    const auto length = readU32({data.data(), data.size()}, offset + 4);
+    if (std::memcmp(id, "CMAP", 4) == 0)
+      entry.numColors = static_cast<std::uint16_t>(std::min<std::size_t>(length / 3, 256));
+    offset += 8 + length + (length & 1);
+  }
+
+  const Span<const std::uint8_t> chunks(data.data() + start, std::min(offset, data.size()) - start);
+  entry.hash = Util::hashContent(chunks.data(), chunks.size(), Util::hashContent(&entry.size, sizeof(entry.size)));
+  // the FORM read ends before the body now
+  const auto formLength = static_cast<std::uint32_t>(chunks.size() - 8);
+  for (auto i = 0; i < 4; i++) {
+    data[start + 4 + i] = static_cast<std::uint8_t>(formLength >> (24 - i * 8));
+  }
+  std::unique_ptr<Ilbm> image;
+  try {
+    image = IlbmLoader::loadWithoutBody(chunks);
+  } catch (const std::runtime_error &e) {
+    fail(path, e.what());
+  }
+  entry.width = image->header.width;
+  entry.height = image->header.height;
+  entry.numPlanes = image->header.num_planes;
+  entry.compression = image->header.compression;
+  entry.masking = image->header.masking;
+  for (const auto &range : SceneFile::getRanges(*image)) {
+    entry.numCycles++;
+    if (range.mode >= 0 && range.mode < 16)
+      entry.cycleModes |= static_cast<std::uint16_t>(1u << range.mode);
+  }
+  return entry;
+}
+
+std::vector<Entry> build(const std::vector<std::string> &paths, const std::vector<Entry> &previous,
+                         std::size_t numThreads, std::vector<std::string> &errors) {
+  TRACE_SCOPE("SceneIndex::build");
+  std::unordered_map<std::string, const Entry *> known;
+  for (const auto &entry : previous) {
+    known.emplace(entry.path, &entry);
+  }
+
+  // the reads wait for the disk most of the time, they are more than the cores; the calling thread reads too
+  std::vector<Entry> entries(paths.size());
+  std::vector<std::string> failures(paths.size());
+  ThreadPool pool(std::max<std::size_t>(numThreads, 1) - 1);
+  pool.parallelFor(paths.size(), BuildGrain, [&](std::size_t begin, std::size_t end) {
+    for (auto i = begin; i < end; i++) {
+      const auto found = known.find(paths[i]);
+      if (found != known.end()) {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(paths[i], error);
+        const auto time = error ? 0 : getTime(paths[i], error);
+        if (!error && size == found->second->size && time == found->second->time) {
+          entries[i] = *found->second;
+          continue;
+        }
+      }
+      try {
+        entries[i] = read(paths[i]);
+      } catch (const std::exception &e) {
+        failures[i] = e.what();
+      }
+    }
+  });
+
+  std::vector<Entry> result;
+  result.reserve(entries.size());
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    if (failures[i].empty()) {
+      result.push_back(std::move(entries[i]));
+    } else {
+      errors.push_back(std::move(failures[i]));
+    }
+  }
+  return result;
+}
+
+void save(const std::vector<Entry> &entries, const std::string &path) {
+  const auto directory = std::filesystem::path(path).parent_path();
+  std::vector<std::uint8_t> out(HeaderSize, 0);
+  std::memcpy(out.data(), Magic, 4);
+  putU16(out.data() + 4, Version);
+  putU32(out.data() + 8, static_cast<std::uint32_t>(entries.size()));
+  for (const auto &entry : entries) {
+    const auto relative = std::filesystem::proximate(entry.path, directory.empty() ? "." : directory).generic_string();
+    if (relative.size() > 0xFFFF) {
+      std::ostringstream ss;
+      ss << "Error when writing " << path << ": the path " << entry.path << " is too long";
+      throw std::runtime_error(ss.str());
+    }
+    const auto offset = out.size();
+    out.resize(offset + EntrySize + 2 + relative.size());
+    auto *e = out.data() + offset;
+    putU64(e, entry.size);
+    putU64(e + 8, static_cast<std::uint64_t>(entry.time));
+    putU64(e + 16, entry.hash);
+    putU16(e + 24, entry.width);
+    putU16(e + 26, entry.height);
+    e[28] = entry.numPlanes;
+    e[29] = entry.compression;
+    e[30] = entry.masking;
+    e[31] = entry.numCycles;
+    putU16(e + 32, entry.cycleModes);
+    putU16(e + 34, entry.numColors);
+    std::memcpy(e + 36, entry.formType, 4);
+    putU16(e + 40, static_cast<std::uint16_t>(relative.size()));
+    std::memcpy(e + 42, relative.data(), relative.size());
+  }
+
+  std::ofstream os(path, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(out.data()), static_cast<std::streamsize>(out.size()));
+  if (!os) {
+    std::ostringstream ss;
+    ss << "Error when writing " << path;
+    throw std::runtime_error(ss.str());
+  }
+}
+
+std::vector<Entry> load(const std::string &path) {
+  TRACE_SCOPE("SceneIndex::load");
+  MappedFile file(path);
+  const auto data = file.getData();
+  if (data.size() < HeaderSize || std::memcmp(data.data(), Magic, 4) != 0)
+    fail(path, "not an index");
+  if (getU16(data.data() + 4) != Version)
+    fail(path, "unsupported index version");
+
+  const auto directory = std::filesystem::path(path).parent_path();
+  const auto numEntries = getU32(data.data() + 8);
+  std::vector<Entry> entries;
+  entries.reserve(std::min<std::size_t>(numEntries, data.size() / EntrySize));
+  std::size_t offset = HeaderSize;
+  for (std::uint32_t i = 0; i < numEntries; i++) {
+    if (data.size() - offset < EntrySize + 2)
+      fail(path, "the entries run past the end of the file");
+    const auto *e = data.data() + offset;
+    const auto pathSize = getU16(e + 40);
+    if (data.size() - offset - EntrySize - 2 < pathSize)
+      fail(path, "the entries run past the end of the file");
+    Entry entry;
+    entry.size = getU64(e);
+    entry.time = static_cast<std::int64_t>(getU64(e + 8));
+    entry.hash = getU64(e + 16);
+    entry.width = getU16(e + 24);
+    entry.height = getU16(e + 26);
+    entry.numPlanes = e[28];
+    entry.compression = e[29];
+    entry.masking = e[30];
+    entry.numCycles = e[31];
+    entry.cycleModes = getU16(e + 32);
+    entry.numColors = getU16(e + 34);
+    std::memcpy(entry.formType, e + 36, 4);
+    const std::string relative(reinterpret_cast<const char *>(e + 42), pathSize);
+    entry.path = directory.empty() ? relative : (directory / relative).lexically_normal().string();
+    entries.push_back(std::move(entry));
+    offset += EntrySize + 2 + pathSize;
+  }
+  return entries;
+}
+
+bool matches(const Entry &entry, const Query &query) {
+  return entry.width >= query.minWidth && entry.width <= query.maxWidth && entry.height >= query.minHeight &&
+         entry.height <= query.maxHeight && (query.numPlanes < 0 || entry.numPlanes == query.numPlanes) &&
+         (query.compression < 0 || entry.compression == query.compression) && entry.numCycles >= query.minCycles &&
+         (entry.cycleModes & query.cycleModes) == query.cycleModes &&
+         (query.formType.empty() || std::string(entry.formType, 4).compare(0, query.formType.size(), query.formType) == 0);
+}
+}// namespace SceneIndex
@@ -0,0 +1,67 @@
+#ifndef COLORCYCLING__SCENEINDEX_H
+#define COLORCYCLING__SCENEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Index of a library of IFF images: what their chunks before the body say, read without the body, to
+ * find scenes without opening every file. Index files (.ccix) are little-endian:
+ *
+ *   header (16 bytes)   "CCIX", version (u16), 0 (u16), number of entries (u32), 0 (u32)
+ *   entries             40 bytes each (the fields of Entry in order, formType last) then the path
+ *                       length (u16) and the path, relative to the directory of the index file
+ */
+namespace SceneIndex {
+constexpr std::uint16_t Version = 1;
+/* bytes read at once from each file, enough for the chunks before the body of most of them */
+constexpr std::size_t ReadSize = 16 * 1024;
+
+struct Entry {
+  std::string path;
+  std::uint64_t size{0};        /* bytes of the file */
+  std::int64_t time{0};         /* last write time, in ticks of the file clock */
+  std::uint64_t hash{0};        /* hash of the chunks before the body and of the file size */
+  std::uint16_t width{0};
+  std::uint16_t height{0};
+  std::uint8_t numPlanes{0};
+  std::uint8_t compression{0};
+  std::uint8_t masking{0};
+  std::uint8_t numCycles{0};    /* active CRNG ranges, the ones with a rate */
+  std::uint16_t cycleModes{0};  /* bit 1 << mode for the modes of the active ranges (CYCLE_NORMAL...) */
+  std::uint16_t numColors{0};   /* CMAP colors */
+  char formType[4]{};           /* "PBM ", "ILBM", "ACBM" or "ANIM" (the other fields are the ones of its first frame) */
+};
+
+/* what a query matches, each field is ignored at its default value */
+struct Query {
+  int minWidth{0}, maxWidth{65535};
+  int minHeight{0}, maxHeight{65535};
+  int numPlanes{-1};
+  int compression{-1};
+  int minCycles{0};
+  std::uint16_t cycleModes{0}; /* all of these modes */
+  std::string formType;
+};
+
+/* reads the chunks before the body of an IFF file, the file is read up to its body only. Throws
+ * std::runtime_error when it can't be read or isn't an IFF image. */
+Entry read(const std::string &path);
+
+/* Reads the entries of paths on numThreads threads reading their files at the same time. The entries of
+ * previous whose file has the same size and time are kept as they are. The files that can't be read are
+ * skipped, their errors are added to errors. The entries are in the order of paths. */
+std::vector<Entry> build(const std::vector<std::string> &paths, const std::vector<Entry> &previous,
+                         std::size_t numThreads, std::vector<std::string> &errors);
+
+/* writes the entries, their paths made relative to the directory of path, throws std::runtime_error on failure */
+void save(const std::vector<Entry> &entries, const std::string &path);
+/* reads an index file, the paths of its entries joined to its directory again, throws std::runtime_error
+ * when it isn't a valid index */
+std::vector<Entry> load(const std::string &path);
+
+bool matches(const Entry &entry, const Query &query);
+}// namespace SceneIndex
+
+#endif//COLORCYCLING__SCENEINDEX_H
@@ -0,0 +1,39 @@
+#ifndef COLORCYCLING__SPAN_H
+#define COLORCYCLING__SPAN_H
+
+#include <cassert>
+#include <cstddef>
+
+/* non-owning view of a contiguous sequence, a subset of C++20 std::span */
+template<typename T>
+class Span {
+public:
+  constexpr Span() noexcept = default;
+  constexpr Span(T *data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+
+  [[nodiscard]] constexpr T *data() const noexcept { return m_data; }
+  [[nodiscard]] constexpr std::size_t size() const noexcept { return m_size; }
+  [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+  [[nodiscard]] constexpr T *begin() const noexcept { return m_data; }
+  [[nodiscard]] constexpr T *end() const noexcept { return m_data + m_size; }
+
+  constexpr T &operator[](std::size_t index) const {
+    assert(index < m_size);
+    return m_data[index];
+  }
+
+  /* count elements from offset, clamped to the end of the view */
+  [[nodiscard]] constexpr Span subspan(std::size_t offset, std::size_t count = static_cast<std::size_t>(-1)) const noexcept {
+    if (offset > m_size)
+      offset = m_size;
+    if (count > m_size - offset)
+      count = m_size - offset;
+    return Span(m_data + offset, count);
+  }
+
+private:
+  T *m_data{nullptr};
+  std::size_t m_size{0};
+};
+
+#endif//COLORCYCLING__SPAN_H
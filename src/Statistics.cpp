@@ -0,0 +1,30 @@
+#include "Statistics.h"
+#include <algorithm>
+
+namespace Statistics {
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  auto pos = p * static_cast<double>(sorted.size() - 1);
+  auto lo = static_cast<std::size_t>(pos);
+  auto hi = std::min(lo + 1, sorted.size() - 1);
+  return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+Summary summarize(std::vector<double> samples) {
+  Summary summary;
+  if (samples.empty())
+    return summary;
+  std::sort(samples.begin(), samples.end());
+  for (auto sample : samples)
+    summary.mean += sample;
+  summary.mean /= static_cast<double>(samples.size());
+  summary.min = samples.front();
+  summary.max = samples.back();
+  summary.p50 = percentile(samples, 0.5);
+  summary.p90 = percentile(samples, 0.9);
+  summary.p95 = percentile(samples, 0.95);
+  summary.p99 = percentile(samples, 0.99);
+  return summary;
+}
+}// namespace Statistics
@@ -0,0 +1,20 @@
+#ifndef COLORCYCLING__STATISTICS_H
+#define COLORCYCLING__STATISTICS_H
+
+#include <vector>
+
+/* distribution of a series of measurements */
+struct Summary {
+  double mean{0};
+  double min{0};
+  double p50{0}, p90{0}, p95{0}, p99{0};
+  double max{0};
+};
+
+namespace Statistics {
+/* linear interpolation between the closest ranks of a sorted series, p in [0, 1] */
+double percentile(const std::vector<double> &sorted, double p);
+Summary summarize(std::vector<double> samples);
+}// namespace Statistics
+
+#endif//COLORCYCLING__STATISTICS_H
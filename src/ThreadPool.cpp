@@ -0,0 +1,113 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace {
+/* ranges of a parallelFor, shared with the helper tasks which may run after it returned */
+struct ParallelRanges {
+  std::function<void(std::size_t, std::size_t)> function;
+  std::size_t count{0};
+  std::size_t grain{1};
+  std::size_t numRanges{0};
+  std::atomic<std::size_t> next{0};
+  std::atomic<std::size_t> done{0};
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::exception_ptr error;
+
+  /* takes ranges until there are none left */
+  void work() {
+    for (auto index = next++; index < numRanges; index = next++) {
+      try {
+        auto begin = index * grain;
+        function(begin, std::min(count, begin + grain));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+      if (++done == numRanges) {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_all();
+      }
+    }
+  }
+};
+}// namespace
+
+ThreadPool::ThreadPool(std::size_t numThreads) {
+  for (std::size_t i = 0; i < numThreads; i++) {
+    m_threads.emplace_back([this] { run(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_condition.notify_all();
+  for (auto &thread : m_threads) {
+    thread.join();
+  }
+}
+
+ThreadPool &ThreadPool::getShared() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+
+void ThreadPool::push(std::function<void()> task) {
+  if (m_threads.empty()) {
+    task();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(task));
+  }
+  m_condition.notify_one();
+}
+
+void ThreadPool::run() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this] { return m_stopping || !m_tasks.empty(); });
+      if (m_tasks.empty())
+        return;
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &function) {
+  grain = std::max<std::size_t>(grain, 1);
+  const auto numRanges = (count + grain - 1) / grain;
+  if (numRanges <= 1 || m_threads.empty()) {
+    if (count > 0)
+      function(0, count);
+    return;
+  }
+
+  auto ranges = std::make_shared<ParallelRanges>();
+  ranges->function = function;
+  ranges->count = count;
+  ranges->grain = grain;
+  ranges->numRanges = numRanges;
+  const auto numHelpers = std::min(m_threads.size(), numRanges - 1);
+  for (std::size_t i = 0; i < numHelpers; i++) {
+    push([ranges] { ranges->work(); });
+  }
+  ranges->work();
+
+  std::unique_lock<std::mutex> lock(ranges->mutex);
+  ranges->condition.wait(lock, [&] { return ranges->done == ranges->numRanges; });
+  if (ranges->error)
+    std::rethrow_exception(ranges->error);
+}
@@ -0,0 +1,54 @@
+#ifndef COLORCYCLING__THREADPOOL_H
+#define COLORCYCLING__THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/* fixed set of worker threads running queued tasks in order */
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t numThreads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /* pool shared by the application, one worker per hardware thread besides the calling one */
+  static ThreadPool &getShared();
+
+  [[nodiscard]] std::size_t getNumThreads() const { return m_threads.size(); }
+
+  /* queues a task, the future gives its result or rethrows its exception */
+  template<typename F>
+  auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    push([packaged] { (*packaged)(); });
+    return future;
+  }
+
+  /* Calls function(begin, end) on consecutive ranges covering [0, count) of about grain items and returns
+   * when all of them are done. The calling thread takes ranges too, so it can be called from a task. */
+  void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &function);
+
+private:
+  void push(std::function<void()> task);
+  void run();
+
+private:
+  std::vector<std::thread> m_threads;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stopping{false};
+};
+
+#endif//COLORCYCLING__THREADPOOL_H
@@ -0,0 +1,68 @@
+#include "ThumbnailTextures.h"
+#include "PaletteExpand.h"
+#include <GL/glew.h>
+
+ThumbnailTextures::~ThumbnailTextures() {
+  for (auto &[path, texture] : m_textures) {
+    glDeleteTextures(1, &texture.id);
+  }
+}
+
+unsigned int ThumbnailTextures::get(const std::string &path, const std::shared_ptr<const Ilbm> &thumbnail, bool animate) {
+  auto &texture = m_textures[path];
+  // drawn twice in a frame, it is stepped once
+  const auto firstUse = !texture.used;
+  texture.used = true;
+  if (texture.thumbnail != thumbnail) {
+    texture.thumbnail = thumbnail;
+    texture.cycled.header = thumbnail->header;
+    texture.cycled.palette = thumbnail->palette;
+    texture.cycled.cycles = thumbnail->cycles;
+    texture.cycled.numCycles = thumbnail->numCycles;
+    texture.cycler.setBasePalette(thumbnail->palette);
+    if (!texture.id) {
+      glGenTextures(1, &texture.id);
+      glBindTexture(GL_TEXTURE_2D, texture.id);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, thumbnail->header.width, thumbnail->header.height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    upload(texture);
+  } else if (animate && firstUse && thumbnail->numCycles > 0 && !thumbnail->isTrueColor()) {
+    texture.cycler.step(texture.cycled);
+    upload(texture);
+  }
+  return texture.id;
+}
+
+void ThumbnailTextures::upload(Texture &texture) {
+  const auto &image = *texture.thumbnail;
+  const std::uint8_t *rgb = image.rgb.data();
+  if (!image.isTrueColor()) {
+    const auto pixels = image.pixels();
+    texture.rgb.resize(pixels.size() * 3);
+    PaletteExpand::toRgb(pixels.data(), pixels.size(), texture.cycled.palette.data(), texture.rgb.data());
+    rgb = texture.rgb.data();
+  }
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(image.stride()));
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.header.width, image.header.height, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void ThumbnailTextures::collect() {
+  for (auto it = m_textures.begin(); it != m_textures.end();) {
+    if (!it->second.used) {
+      glDeleteTextures(1, &it->second.id);
+      it = m_textures.erase(it);
+    } else {
+      it->second.used = false;
+      ++it;
+    }
+  }
+}
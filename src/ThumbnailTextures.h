@@ -0,0 +1,44 @@
+#ifndef COLORCYCLING__THUMBNAILTEXTURES_H
+#define COLORCYCLING__THUMBNAILTEXTURES_H
+
+#include "ColorCycler.h"
+#include "Ilbm.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* RGB textures of the thumbnails shown by the file dialog, their ranges cycled while they are animated.
+ * Needs a current GL context. */
+class ThumbnailTextures {
+public:
+  ThumbnailTextures() = default;
+  ~ThumbnailTextures();
+
+  ThumbnailTextures(const ThumbnailTextures &) = delete;
+  ThumbnailTextures &operator=(const ThumbnailTextures &) = delete;
+
+  /* the texture of the thumbnail of path, its palette stepped by one tick when animate is true */
+  unsigned int get(const std::string &path, const std::shared_ptr<const Ilbm> &thumbnail, bool animate);
+  /* deletes the textures not drawn since the previous call, once per frame */
+  void collect();
+
+private:
+  struct Texture {
+    unsigned int id{0};
+    std::shared_ptr<const Ilbm> thumbnail;
+    /* the cycled palette, its pixels stay in thumbnail */
+    Ilbm cycled;
+    ColorCycler cycler;
+    std::vector<std::uint8_t> rgb;
+    bool used{false};
+  };
+
+  void upload(Texture &texture);
+
+private:
+  std::unordered_map<std::string, Texture> m_textures;
+};
+
+#endif//COLORCYCLING__THUMBNAILTEXTURES_H
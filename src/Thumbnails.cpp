@@ -0,0 +1,146 @@
+#include "Thumbnails.h"
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include "SceneFile.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+/* requests waiting to be made, the older ones are dropped when the directory is scrolled quickly */
+constexpr std::size_t MaxQueued = 64;
+
+std::unique_ptr<Ilbm> makeThumbnail(const std::string &path, int maxSize) {
+  TRACE_SCOPE("Thumbnails::make");
+  std::unique_ptr<Ilbm> image;
+  {
+    MappedFile file(path);
+    if (!SceneFile::isSceneFile(file.getData())) {
+      try {
+        image = IlbmLoader::loadThumbnail(file.getData());
+      } catch (const std::runtime_error &) {
+        // the whole image then
+      }
+    }
+  }
+  if (!image)
+    image = IlbmLoader::load(path);
+  return Thumbnails::downscale(*image, maxSize);
+}
+}// namespace
+
+Thumbnails::Thumbnails(int maxSize, std::size_t maxCount) : m_maxSize(maxSize), m_maxCount(maxCount), m_thread([this] { run(); }) {}
+
+Thumbnails::~Thumbnails() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  m_thread.join();
+}
+
+std::shared_ptr<const Ilbm> Thumbnails::get(const std::string &path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto [found, inserted] = m_entries.try_emplace(path);
+  auto &entry = found->second;
+  entry.lastUse = ++m_clock;
+  if (inserted || entry.state == State::Queued) {
+    // the last requested first
+    if (!inserted)
+      m_queue.erase(std::find(m_queue.begin(), m_queue.end(), path));
+    m_queue.push_back(path);
+    if (m_queue.size() > MaxQueued) {
+      m_entries.erase(m_queue.front());
+      m_queue.pop_front();
+    }
+    m_condition.notify_one();
+  }
+  auto thumbnail = entry.state == State::Done ? entry.thumbnail : nullptr;
+  trim();
+  return thumbnail;
+}
+
+std::unique_ptr<Ilbm> Thumbnails::downscale(const Ilbm &image, int maxSize) {
+  const std::size_t width = image.header.width;
+  const std::size_t height = image.header.height;
+  const auto trueColor = image.isTrueColor();
+  const auto bytesPerPixel = trueColor ? 3u : 1u;
+  const auto pixels = trueColor ? Span<const std::uint8_t>(image.rgb.data(), image.rgb.size()) : image.pixels();
+  if (width == 0 || height == 0 || pixels.size() < image.stride() * height * bytesPerPixel)
+    return nullptr;
+
+  auto thumbnail = std::make_unique<Ilbm>();
+  thumbnail->header = image.header;
+  thumbnail->palette = image.palette;
+  thumbnail->cycles = image.cycles;
+  thumbnail->numCycles = image.numCycles;
+  const auto size = std::max(width, height);
+  const auto limit = static_cast<std::size_t>(std::max(maxSize, 1));
+  const auto thumbnailWidth = size > limit ? std::max<std::size_t>(1, width * limit / size) : width;
+  const auto thumbnailHeight = size > limit ? std::max<std::size_t>(1, height * limit / size) : height;
+  thumbnail->header.width = static_cast<unsigned short>(thumbnailWidth);
+  thumbnail->header.height = static_cast<unsigned short>(thumbnailHeight);
+
+  const auto stride = thumbnail->stride() * bytesPerPixel;
+  std::vector<std::uint8_t> out(stride * thumbnailHeight, 0);
+  for (std::size_t y = 0; y < thumbnailHeight; y++) {
+    const auto *row = pixels.data() + (2 * y + 1) * height / (2 * thumbnailHeight) * image.stride() * bytesPerPixel;
+    for (std::size_t x = 0; x < thumbnailWidth; x++) {
+      const auto sourceX = (2 * x + 1) * width / (2 * thumbnailWidth);
+      std::memcpy(out.data() + y * stride + x * bytesPerPixel, row + sourceX * bytesPerPixel, bytesPerPixel);
+    }
+  }
+  if (trueColor) {
+    thumbnail->rgb = std::move(out);
+  } else {
+    thumbnail->image = std::move(out);
+  }
+  return thumbnail;
+}
+
+void Thumbnails::run() {
+  for (;;) {
+    std::string path;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+      if (m_stop)
+        return;
+      path = std::move(m_queue.back());
+      m_queue.pop_back();
+      m_entries[path].state = State::Making;
+    }
+
+    std::shared_ptr<const Ilbm> thumbnail;
+    try {
+      thumbnail = makeThumbnail(path, m_maxSize);
+    } catch (const std::exception &) {
+      // shown without thumbnail
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_entries.find(path);
+    if (found != m_entries.end()) {
+      found->second.state = thumbnail ? State::Done : State::Failed;
+      found->second.thumbnail = std::move(thumbnail);
+    }
+  }
+}
+
+void Thumbnails::trim() {
+  if (m_entries.size() <= m_maxCount)
+    return;
+  // down to 3/4 of maxCount, not to sort them again at the next request
+  std::vector<std::pair<std::uint64_t, const std::string *>> made;
+  for (const auto &[path, entry] : m_entries) {
+    if (entry.state == State::Done || entry.state == State::Failed)
+      made.emplace_back(entry.lastUse, &path);
+  }
+  std::sort(made.begin(), made.end());
+  const auto numErased = std::min(made.size(), m_entries.size() - m_maxCount * 3 / 4);
+  for (std::size_t i = 0; i < numErased; i++) {
+    m_entries.erase(*made[i].second);
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef COLORCYCLING__THUMBNAILS_H
+#define COLORCYCLING__THUMBNAILS_H
+
+#include "Ilbm.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/* Thumbnails of image files, made on a worker thread from their TINY chunk when they have one, otherwise
+ * from their whole image, and kept for the next requests. The last requested are made first, the oldest
+ * requests are dropped when too many wait. A thumbnail keeps the palette and the ranges of its image. */
+class Thumbnails {
+public:
+  /* thumbnails fit in maxSize x maxSize pixels, at most maxCount of them are kept */
+  explicit Thumbnails(int maxSize = 96, std::size_t maxCount = 512);
+  ~Thumbnails();
+
+  Thumbnails(const Thumbnails &) = delete;
+  Thumbnails &operator=(const Thumbnails &) = delete;
+
+  /* the thumbnail of path, null until it is made or when the file can't be read. The first call queues it. */
+  std::shared_ptr<const Ilbm> get(const std::string &path);
+  /* the thumbnail of an image, which keeps its indices: each pixel is the one nearest to its center */
+  static std::unique_ptr<Ilbm> downscale(const Ilbm &image, int maxSize);
+
+private:
+  enum class State { Queued, Making, Done, Failed };
+
+  struct Entry {
+    State state{State::Queued};
+    std::shared_ptr<const Ilbm> thumbnail;
+    std::uint64_t lastUse{0};
+  };
+
+  void run();
+  /* drops the thumbnails used the longest ago, the lock is held */
+  void trim();
+
+private:
+  int m_maxSize;
+  std::size_t m_maxCount;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::unordered_map<std::string, Entry> m_entries;
+  std::deque<std::string> m_queue; /* the last requested at the back */
+  std::uint64_t m_clock{0};
+  bool m_stop{false};
+  std::thread m_thread;
+};
+
+#endif//COLORCYCLING__THUMBNAILS_H
@@ -0,0 +1,86 @@
+#include "Trace.h"
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Trace {
+namespace {
+/* bounds the memory used by a trace left running, about 32 MB */
+constexpr std::size_t MaxEvents = 1u << 20;
+
+struct Event {
+  const char *name;
+  std::int64_t start;/* in ns since the start of the trace */
+  std::int64_t duration;
+  int thread;
+};
+
+std::mutex mutex;
+std::string outputPath;
+std::chrono::steady_clock::time_point origin;
+std::vector<Event> events;
+
+int getThreadIndex() {
+  static std::atomic<int> count{0};
+  thread_local int index = count++;
+  return index;
+}
+
+std::int64_t toNanoseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+void writeEscaped(FILE *file, const char *text) {
+  for (; *text; text++) {
+    if (*text == '"' || *text == '\\')
+      std::fputc('\\', file);
+    std::fputc(*text, file);
+  }
+}
+}// namespace
+
+namespace Detail {
+std::atomic<bool> enabled{false};
+
+void record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+  const auto thread = getThreadIndex();
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!enabled.load(std::memory_order_relaxed) || events.size() >= MaxEvents)
+    return;
+  events.push_back({name, toNanoseconds(start - origin), toNanoseconds(end - start), thread});
+}
+}// namespace Detail
+
+void start(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  outputPath = path;
+  origin = std::chrono::steady_clock::now();
+  events.clear();
+  events.reserve(4096);
+  Detail::enabled.store(true);
+}
+
+bool stop() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!Detail::enabled.exchange(false))
+    return true;
+
+  FILE *file = std::fopen(outputPath.c_str(), "w");
+  if (!file)
+    return false;
+  std::fputs("{\"traceEvents\":[\n", file);
+  for (std::size_t i = 0; i < events.size(); i++) {
+    const auto &event = events[i];
+    std::fputs("{\"name\":\"", file);
+    writeEscaped(file, event.name);
+    // timestamps are in µs
+    std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n", event.thread,
+                 static_cast<double>(event.start) / 1e3, static_cast<double>(event.duration) / 1e3, i + 1 < events.size() ? "," : "");
+  }
+  std::fputs("],\"displayTimeUnit\":\"ms\"}\n", file);
+  events.clear();
+  events.shrink_to_fit();
+  return std::fclose(file) == 0;
+}
+}// namespace Trace
@@ -0,0 +1,52 @@
+#ifndef COLORCYCLING__TRACE_H
+#define COLORCYCLING__TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/* Scoped zones written as Chrome trace events (chrome://tracing, Perfetto).
+ * While no trace is running a zone costs a relaxed atomic load, defining COLORCYCLING_NO_TRACE removes them. */
+namespace Trace {
+/* starts recording, the events are written to path by stop */
+void start(const std::string &path);
+/* writes the recorded events, returns false when the file could not be written */
+bool stop();
+
+namespace Detail {
+extern std::atomic<bool> enabled;
+void record(const char *name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+}// namespace Detail
+
+inline bool isEnabled() { return Detail::enabled.load(std::memory_order_relaxed); }
+
+/* records the duration of its scope, name must outlive the trace (a string literal) */
+class Zone {
+public:
+  explicit Zone(const char *name) : m_name(isEnabled() ? name : nullptr) {
+    if (m_name)
+      m_start = std::chrono::steady_clock::now();
+  }
+  ~Zone() {
+    if (m_name)
+      Detail::record(m_name, m_start, std::chrono::steady_clock::now());
+  }
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+private:
+  const char *m_name;
+  std::chrono::steady_clock::time_point m_start;
+};
+}// namespace Trace
+
+#define COLORCYCLING_TRACE_CONCAT_(a, b) a##b
+#define COLORCYCLING_TRACE_CONCAT(a, b) COLORCYCLING_TRACE_CONCAT_(a, b)
+#ifdef COLORCYCLING_NO_TRACE
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_SCOPE(name) Trace::Zone COLORCYCLING_TRACE_CONCAT(traceZone, __LINE__)(name)
+#endif
+
+#endif//COLORCYCLING__TRACE_H
@@ -1,6 +1,28 @@
 #include "Util.h"
+#include <cstring>
 
 namespace Util {
+namespace {
+constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+
+inline std::uint64_t rotl(std::uint64_t x, int r) {
+  return x << r | x >> (64 - r);
+}
+
+inline std::uint64_t readU64(const std::uint8_t *data) {
+  std::uint64_t value;
+  std::memcpy(&value, data, 8);
+  return value;
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+  return rotl(acc + input * Prime2, 31) * Prime1;
+}
+}// namespace
+
 unsigned int nextPow2(unsigned int x) {
   --x;
   x |= x >> 1;
@@ -11,6 +33,41 @@ unsigned int nextPow2(unsigned int x) {
   return x + 1;
 }
 
+std::uint64_t hash64(const void *data, std::size_t size) {
+  auto hash = 0xcbf29ce484222325ull;
+  const auto *bytes = static_cast<const std::uint8_t *>(data);
+  for (std::size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+std::uint64_t hashContent(const void *data, std::size_t size, std::uint64_t seed) {
+  const auto *bytes = static_cast<const std::uint8_t *>(data);
+  std::uint64_t lanes[4] = {seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1};
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    for (auto k = 0; k < 4; k++) {
+      lanes[k] = round(lanes[k], readU64(bytes + i + k * 8));
+    }
+  }
+  auto hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+  for (auto lane : lanes) {
+    hash = (hash ^ round(0, lane)) * Prime1 + Prime4;
+  }
+  hash += size;
+  for (; i < size; i++) {
+    hash = rotl(hash ^ bytes[i] * Prime3, 11) * Prime1;
+  }
+  // avalanche
+  hash ^= hash >> 33;
+  hash *= Prime2;
+  hash ^= hash >> 29;
+  hash *= Prime3;
+  return hash ^ hash >> 32;
+}
+
 void endianSwap(int32_t *value) {
   unsigned char *chs;
   unsigned char temp;
@@ -1,6 +1,7 @@
 #ifndef COLORCYCLING__UTIL_H
 #define COLORCYCLING__UTIL_H
 
+#include <cstddef>
 #include <cstdint>
 
 namespace Util {
@@ -8,6 +9,11 @@ void endianSwap(int32_t *value);
 void endianSwap(int16_t *value);
 void endianSwap(uint16_t *value);
 unsigned int nextPow2(unsigned int x);
+/* 64-bit FNV-1a hash */
+std::uint64_t hash64(const void *data, std::size_t size);
+/* 64-bit hash of large buffers, 32 bytes at a time on 4 independent lanes (the xxHash64 rounds), about
+ * 10 times faster than hash64. seed chains several buffers into one hash. */
+std::uint64_t hashContent(const void *data, std::size_t size, std::uint64_t seed = 0);
 }// namespace Util
 
 #endif//COLORCYCLING__UTIL_H
@@ -0,0 +1,139 @@
+#include "VerticalRle.h"
+#include "IffReader.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VerticalRle {
+namespace {
+/* words per side of the transposed tiles, the columns and the rows of a tile stay in L1 */
+constexpr std::size_t TileSize = 32;
+/* largest count of the commands followed by a 16-bit count */
+constexpr std::size_t MaxCount = 0xffff;
+
+/* columns holds numColumns columns of height 16-bit words, plane gets height rows of numColumns words */
+void transpose(const std::uint8_t *columns, std::size_t numColumns, std::size_t height, std::uint8_t *plane) {
+  for (std::size_t y0 = 0; y0 < height; y0 += TileSize) {
+    const auto y1 = std::min(height, y0 + TileSize);
+    for (std::size_t x0 = 0; x0 < numColumns; x0 += TileSize) {
+      const auto x1 = std::min(numColumns, x0 + TileSize);
+      for (auto x = x0; x < x1; x++) {
+        const auto *column = columns + x * height * 2;
+        for (auto y = y0; y < y1; y++) {
+          std::memcpy(plane + (y * numColumns + x) * 2, column + y * 2, 2);
+        }
+      }
+    }
+  }
+}
+
+void putU16(std::vector<std::uint8_t> &out, std::size_t value) {
+  out.push_back(static_cast<std::uint8_t>(value >> 8));
+  out.push_back(static_cast<std::uint8_t>(value));
+}
+}// namespace
+
+void decodePlane(Span<const std::uint8_t> vdat, std::size_t lineSize, std::size_t height, std::uint8_t *plane) {
+  const auto numColumns = lineSize / 2;
+  const auto numWords = numColumns * height;
+  std::vector<std::uint8_t> columns(numWords * 2);
+  if (vdat.size() >= 2) {
+    const auto commandsEnd = std::min<std::size_t>(vdat.size(), std::max<std::size_t>(readU16(vdat, 0), 2));
+    std::size_t command = 2, data = commandsEnd, word = 0;
+    while (command < commandsEnd && word < numWords) {
+      const auto n = static_cast<std::int8_t>(vdat[command++]);
+      /* 0: a count then literal words, 1: a count then a repeated word,
+       * [-128..-1]: -n literal words, [2..127]: a word repeated n times */
+      std::size_t count;
+      if (n == 0 || n == 1) {
+        if (data + 2 > vdat.size())
+          break;
+        count = readU16(vdat, data);
+        data += 2;
+      } else {
+        count = static_cast<std::size_t>(n < 0 ? -n : n);
+      }
+      count = std::min(count, numWords - word);
+
+      if (n <= 0) {
+        const auto available = std::min(count, (vdat.size() - data) / 2);
+        std::memcpy(columns.data() + word * 2, vdat.data() + data, available * 2);
+        data += available * 2;
+        word += available;
+        if (available < count)
+          break;
+      } else {
+        if (data + 2 > vdat.size())
+          break;
+        const std::uint8_t value[2] = {vdat[data], vdat[data + 1]};
+        data += 2;
+        for (std::size_t i = 0; i < count; i++) {
+          std::memcpy(columns.data() + (word + i) * 2, value, 2);
+        }
+        word += count;
+      }
+    }
+  }
+  transpose(columns.data(), numColumns, height, plane);
+}
+
+void encodePlane(const std::uint8_t *plane, std::size_t lineSize, std::size_t height, std::vector<std::uint8_t> &out) {
+  const auto numColumns = lineSize / 2;
+  std::vector<std::uint16_t> words;
+  words.reserve(numColumns * height);
+  for (std::size_t x = 0; x < numColumns; x++) {
+    for (std::size_t y = 0; y < height; y++) {
+      words.push_back(static_cast<std::uint16_t>(plane[y * lineSize + x * 2] << 8 | plane[y * lineSize + x * 2 + 1]));
+    }
+  }
+
+  std::vector<std::uint8_t> commands, data;
+  std::size_t i = 0;
+  while (i < words.size()) {
+    const auto remaining = words.size() - i;
+    // the number of commands has to fit in 16 bits with the count itself, the end is stored as literals then
+    if (commands.size() + 2 + remaining / MaxCount + 1 >= MaxCount) {
+      const auto count = std::min(remaining, MaxCount);
+      commands.push_back(0);
+      putU16(data, count);
+      for (std::size_t j = 0; j < count; j++)
+        putU16(data, words[i + j]);
+      i += count;
+      continue;
+    }
+
+    std::size_t run = 1;
+    while (i + run < words.size() && run < MaxCount && words[i + run] == words[i])
+      run++;
+    if (run >= 2) {
+      if (run <= 127) {
+        commands.push_back(static_cast<std::uint8_t>(run));
+      } else {
+        commands.push_back(1);
+        putU16(data, run);
+      }
+      putU16(data, words[i]);
+      i += run;
+      continue;
+    }
+
+    // literals until the next run
+    auto end = i + 1;
+    while (end < words.size() && end - i < MaxCount && !(end + 1 < words.size() && words[end] == words[end + 1]))
+      end++;
+    const auto count = end - i;
+    if (count <= 128) {
+      commands.push_back(static_cast<std::uint8_t>(256 - count));
+    } else {
+      commands.push_back(0);
+      putU16(data, count);
+    }
+    for (auto j = i; j < end; j++)
+      putU16(data, words[j]);
+    i = end;
+  }
+
+  putU16(out, commands.size() + 2);
+  out.insert(out.end(), commands.begin(), commands.end());
+  out.insert(out.end(), data.begin(), data.end());
+}
+}// namespace VerticalRle
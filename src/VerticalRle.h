@@ -0,0 +1,22 @@
+#ifndef COLORCYCLING__VERTICALRLE_H
+#define COLORCYCLING__VERTICALRLE_H
+
+#include "Span.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Vertical RLE (BMHD compression 2) of the Atari ST ILBM files: the BODY holds one VDAT chunk per plane.
+ * A VDAT chunk starts with the number of command bytes + 2 (16 bits), then the commands, then the data
+ * words. The words fill the plane column by column, a column being 16 pixels wide and the image high. */
+namespace VerticalRle {
+/* Decodes the data of a VDAT chunk into a plane of height lines of lineSize bytes. The words are written
+ * column by column into a scratch buffer, then transposed tile by tile into the rows. What the data
+ * doesn't cover is left 0, never reads or writes out of bounds whatever the data contains. */
+void decodePlane(Span<const std::uint8_t> vdat, std::size_t lineSize, std::size_t height, std::uint8_t *plane);
+
+/* appends the data of a VDAT chunk (without its header) encoding a plane of height lines of lineSize bytes */
+void encodePlane(const std::uint8_t *plane, std::size_t lineSize, std::size_t height, std::vector<std::uint8_t> &out);
+}// namespace VerticalRle
+
+#endif//COLORCYCLING__VERTICALRLE_H
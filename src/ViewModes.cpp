@@ -0,0 +1,76 @@
+#include "ViewModes.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+namespace ViewModes {
+namespace {
+/* images from this number of pixels get their rows resolved in parallel */
+constexpr std::size_t ParallelResolveThreshold = 1u << 20;
+/* number of pixels resolved by a task */
+constexpr std::size_t ParallelResolveGrain = 1u << 16;
+
+/* colors are packed as 0x00BBGGRR */
+std::uint32_t pack(const std::uint8_t *color) {
+  return color[0] | static_cast<std::uint32_t>(color[1]) << 8 | static_cast<std::uint32_t>(color[2]) << 16;
+}
+}// namespace
+
+void extendHalfBrite(std::array<std::uint8_t, 256 * 3> &palette) {
+  for (auto i = 0; i < 32 * 3; i++) {
+    palette[32 * 3 + i] = static_cast<std::uint8_t>(palette[i] >> 1);
+  }
+}
+
+HamResolver::HamResolver(int numPlanes, const std::uint8_t *palette) : m_start(pack(palette)) {
+  // the control bits are the 2 upper planes: palette, modify blue, modify red, modify green
+  const auto shift = numPlanes - 2;
+  const auto numValues = 1 << shift;
+  const int components[] = {16, 0, 8};
+  m_keep.fill(0);
+  m_set.fill(0);
+  for (auto index = 0; index < numValues * 4; index++) {
+    const auto value = static_cast<std::uint32_t>(index & (numValues - 1));
+    const auto control = index >> shift;
+    if (control == 0) {
+      m_set[index] = pack(palette + value * 3);
+      continue;
+    }
+    const auto component = components[control - 1];
+    // HAM6 values are whole 4-bit components, HAM8 ones replace the upper 6 bits and keep the lower 2
+    m_keep[index] = 0xFFFFFFu & ~((numPlanes == 6 ? 0xFFu : 0xFCu) << component);
+    m_set[index] = (numPlanes == 6 ? value * 0x11 : value << 2) << component;
+  }
+}
+
+void HamResolver::resolveRow(const std::uint8_t *indices, std::size_t width, std::uint8_t *rgb) const {
+  auto color = m_start;
+  for (std::size_t x = 0; x < width; x++) {
+    color = (color & m_keep[indices[x]]) | m_set[indices[x]];
+    rgb[x * 3] = static_cast<std::uint8_t>(color);
+    rgb[x * 3 + 1] = static_cast<std::uint8_t>(color >> 8);
+    rgb[x * 3 + 2] = static_cast<std::uint8_t>(color >> 16);
+  }
+}
+
+void resolveHam(Ilbm &image) {
+  TRACE_SCOPE("resolveHam");
+  const auto stride = image.stride();
+  const auto pixels = image.pixels();
+  const auto height = std::min<std::size_t>(image.header.height, stride ? pixels.size() / stride : 0);
+  image.rgb.resize(stride * image.header.height * 3);
+  const HamResolver resolver(image.header.num_planes, image.palette.data());
+  const auto resolveRows = [&](std::size_t begin, std::size_t end) {
+    for (auto y = begin; y < end; y++) {
+      resolver.resolveRow(pixels.data() + y * stride, image.header.width, image.rgb.data() + y * stride * 3);
+    }
+  };
+
+  auto &pool = ThreadPool::getShared();
+  if (stride * height < ParallelResolveThreshold || pool.getNumThreads() == 0) {
+    resolveRows(0, height);
+    return;
+  }
+  pool.parallelFor(height, std::max<std::size_t>(1, ParallelResolveGrain / stride), resolveRows);
+}
+}// namespace ViewModes
@@ -0,0 +1,34 @@
+#ifndef COLORCYCLING__VIEWMODES_H
+#define COLORCYCLING__VIEWMODES_H
+
+#include "Ilbm.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/* the Amiga display modes of the CAMG chunk which change how the indices become colors */
+namespace ViewModes {
+/* sets colors 32 to 63 to colors 0 to 31 at half brightness, like the Extra-Half-Brite display */
+void extendHalfBrite(std::array<std::uint8_t, 256 * 3> &palette);
+
+/* Resolves the lines of a HAM image of numPlanes (6 or 8) into RGB, from color 0 like each line of the display.
+ * A pixel is a color of the palette (16 or 64 of them) or the previous one with its blue, red or green modified:
+ * 4 bits repeated for HAM6, the 6 upper bits for HAM8. Each index is a mask of the previous color kept and the
+ * bits set, so a line has no branch. */
+class HamResolver {
+public:
+  HamResolver(int numPlanes, const std::uint8_t *palette);
+
+  void resolveRow(const std::uint8_t *indices, std::size_t width, std::uint8_t *rgb) const;
+
+private:
+  std::uint32_t m_start;
+  std::array<std::uint32_t, 256> m_keep;
+  std::array<std::uint32_t, 256> m_set;
+};
+
+/* resolves the indices of a HAM image into its rgb with its current palette, rgb is allocated when it is empty */
+void resolveHam(Ilbm &image);
+}// namespace ViewModes
+
+#endif//COLORCYCLING__VIEWMODES_H
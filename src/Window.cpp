@@ -1,4 +1,5 @@
 #include "Window.h"
+#include "Trace.h"
 #include <GL/glew.h>
 #include <SDL.h>
 #include <imgui.h>
@@ -8,7 +9,7 @@
 
 Window::Window() = default;
 
-void Window::init() {
+void Window::init(bool hidden) {
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0) {
     std::ostringstream ss;
     ss << "Error when initializing SDL (error=" << SDL_GetError() << ")";
@@ -40,9 +41,14 @@ void Window::init() {
   SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
   SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
   auto window_flags = (SDL_WindowFlags)(
-      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
+      SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI | (hidden ? SDL_WINDOW_HIDDEN : 0));
   m_window = SDL_CreateWindow("SDL/OpenGL Color cycling", SDL_WINDOWPOS_CENTERED,
                               SDL_WINDOWPOS_CENTERED, 1280, 720, window_flags);
+  if (!m_window) {
+    std::ostringstream ss;
+    ss << "Error when creating window (error=" << SDL_GetError() << ")";
+    throw std::runtime_error(ss.str());
+  }
 
   // setup OpenGL
   m_glContext = SDL_GL_CreateContext(m_window);
@@ -83,7 +89,12 @@ void Window::init() {
   ImGui_ImplOpenGL3_Init(glsl_version);
 }
 
+void Window::setVerticalSyncEnabled(bool enabled) {
+  SDL_GL_SetSwapInterval(enabled ? 1 : 0);
+}
+
 void Window::display() {
+  TRACE_SCOPE("Window::display");
   SDL_GL_SwapWindow(m_window);
 }
 
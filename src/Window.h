@@ -8,7 +8,8 @@ public:
   Window();
   ~Window();
 
-  void init();
+  void init(bool hidden = false);
+  void setVerticalSyncEnabled(bool enabled);
   void display();
   bool pollEvent(SDL_Event& event);
 
@@ -1,8 +1,82 @@
 #include "ColorCyclingApplication.h"
+#include "OffscreenHarness.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+
+namespace {
+void usage() {
+  std::cerr << "usage: ColorCycling [--trace FILE] [--cache MB] [file.lbm]\n"
+               "       ColorCycling --benchmark [--frames N] <file.lbm>\n"
+               "       ColorCycling --offscreen [--frames N] <file.lbm>\n"
+               "  --trace FILE  writes a Chrome trace (chrome://tracing, ui.perfetto.dev) of the frames and loads\n"
+               "  --cache MB    memory kept for the decoded images, to switch back to them without decoding (default 256)\n"
+               "  --benchmark   runs N frames (default 300) without vsync and prints the distribution of the\n"
+               "                frame times split into events, update, upload, draw, imgui and swap\n"
+               "  --offscreen   renders N frames (default 300) into a framebuffer object of a hidden window,\n"
+               "                reads them back and prints the cost of each phase, for GPU-less machines use\n"
+               "                SDL_VIDEODRIVER=offscreen LIBGL_ALWAYS_SOFTWARE=1 to run on Mesa llvmpipe\n";
+}
+}// namespace
 
 int main(int argc, const char **argv) {
-  ColorCyclingApplication app;
-  app.run();
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+  std::string path;
+  auto offscreen = false;
+  auto benchmark = false;
+  std::string tracePath;
+  auto frames = 300;
+  auto cacheSize = -1;
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--offscreen") {
+      offscreen = true;
+    } else if (arg == "--trace" && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (arg == "--benchmark") {
+      benchmark = true;
+    } else if (arg == "--frames" && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cacheSize = std::max(std::atoi(argv[++i]), 0);
+    } else if (arg[0] == '-' || !path.empty()) {
+      usage();
+      return EXIT_FAILURE;
+    } else {
+      path = arg;
+    }
+  }
+
+  if ((offscreen || benchmark) && (path.empty() || frames <= 0)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  if (!tracePath.empty()) {
+    Trace::start(tracePath);
+  }
+  auto result = EXIT_SUCCESS;
+  try {
+    if (offscreen) {
+      result = OffscreenHarness::run(path, frames);
+    } else {
+      ColorCyclingApplication app(path);
+      if (cacheSize >= 0) {
+        app.setCacheBudget(static_cast<std::size_t>(cacheSize) << 20);
+      }
+      if (benchmark) {
+        app.setBenchmark(frames);
+      }
+      app.run();
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    result = EXIT_FAILURE;
+  }
+  if (!Trace::stop()) {
+    std::cerr << "Error when writing the trace " << tracePath << std::endl;
+    result = EXIT_FAILURE;
+  }
+  return result;
+}
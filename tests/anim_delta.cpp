@@ -0,0 +1,116 @@
+#include "Anim.h"
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* deltas written by hand from the ANIM spec, not by IlbmWriter: a 16x6 image of 1 plane, all 0, changed by one
+ * DLTA of operation 5 or 7 whose ops are a skip of 1 to 127 rows, a run of one item (0, the number of rows) or
+ * items copied one per row (bit 7 set, their number) */
+namespace {
+using Bytes = std::vector<std::uint8_t>;
+
+constexpr int Width = 16, Height = 6;
+
+bool check(bool condition, const char *what) {
+  if (!condition)
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  return condition;
+}
+
+void putU32(Bytes &out, std::uint32_t value) {
+  for (auto shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<std::uint8_t>(value >> shift));
+  }
+}
+
+void putChunk(Bytes &out, const char *id, const Bytes &data) {
+  out.insert(out.end(), id, id + 4);
+  putU32(out, static_cast<std::uint32_t>(data.size()));
+  out.insert(out.end(), data.begin(), data.end());
+  if (data.size() % 2 != 0)
+    out.push_back(0);
+}
+
+Bytes form(const char *type, const Bytes &chunks) {
+  Bytes data(type, type + 4);
+  data.insert(data.end(), chunks.begin(), chunks.end());
+  Bytes out;
+  putChunk(out, "FORM", data);
+  return out;
+}
+
+/* an ANIM of the blank image then the frame of dlta */
+Bytes anim(std::uint8_t operation, std::uint32_t bits, const Bytes &dlta) {
+  Bytes first;
+  putChunk(first, "BMHD", {0, Width, 0, Height, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 0, Width, 0, Height});
+  putChunk(first, "CMAP", {0, 0, 0, 255, 255, 255});
+  putChunk(first, "BODY", Bytes(2 * Height, 0));
+  Bytes header(40, 0);
+  header[0] = operation;
+  header[17] = 1;
+  header[23] = static_cast<std::uint8_t>(bits);
+  Bytes delta;
+  putChunk(delta, "ANHD", header);
+  putChunk(delta, "DLTA", dlta);
+  auto frames = form("ILBM", first);
+  const auto next = form("ILBM", delta);
+  frames.insert(frames.end(), next.begin(), next.end());
+  return form("ANIM", frames);
+}
+
+/* the frame after the first one, as the bytes of its single plane, or empty when it can't be played */
+Bytes play(const Bytes &file) {
+  const auto path = (std::filesystem::temp_directory_path() / "colorcycling-anim-delta.anim").string();
+  {
+    std::ofstream os(path, std::ios::binary);
+    os.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+  }
+  Bytes plane;
+  try {
+    auto image = IlbmLoader::load(path);
+    Anim anim(std::make_shared<const MappedFile>(path), *image);
+    anim.next(*image);
+    const auto pixels = image->pixels();
+    for (auto y = 0; y < Height; y++) {
+      for (auto x = 0; x < Width; x += 8) {
+        std::uint8_t byte = 0;
+        for (auto bit = 0; bit < 8; bit++) {
+          byte = static_cast<std::uint8_t>(byte << 1 | pixels[y * image->stride() + x + bit]);
+        }
+        plane.push_back(byte);
+      }
+    }
+  } catch (const std::runtime_error &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+  }
+  std::filesystem::remove(path);
+  return plane;
+}
+}// namespace
+
+int main() {
+  // operation 5, one list of bytes: the column 0 skips a row, copies 2 bytes then runs 0xaa over 2 rows, the
+  // column 1 runs 0x81 over the 6 rows
+  Bytes bytes(16 * 4, 0);
+  bytes[3] = 64;
+  bytes.insert(bytes.end(), {3, 0x01, 0x82, 0xff, 0x0f, 0x00, 0x02, 0xaa, 1, 0x00, 0x06, 0x81});
+  auto ok = check(play(anim(5, 0, bytes)) == Bytes{0x00, 0x81, 0xff, 0x81, 0x0f, 0x81, 0xaa, 0x81, 0xaa, 0x81, 0x00, 0x81},
+                  "operation 5 skips, copies and runs bytes");
+
+  // operation 7, the ops then the shorts: the single column skips 2 rows, copies a short then runs another over
+  // 2 rows
+  Bytes shorts(16 * 4, 0);
+  shorts[3] = 64;
+  shorts[35] = 70;
+  shorts.insert(shorts.end(), {3, 0x02, 0x81, 0x00, 0x02, 0, 0x12, 0x34, 0x56, 0x78});
+  ok = check(play(anim(7, 0, shorts)) == Bytes{0, 0, 0, 0, 0x12, 0x34, 0x56, 0x78, 0x56, 0x78, 0, 0},
+             "operation 7 skips, copies and runs shorts") &&
+       ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
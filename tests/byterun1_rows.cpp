@@ -0,0 +1,32 @@
+#include "ByteRun1.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* findRows stops at the end of a truncated BODY: a run whose data is cut by the end of the source is never
+ * skipped past it, which the next header read would overflow */
+namespace {
+bool check(bool condition, const char *what) {
+  if (!condition)
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  return condition;
+}
+
+/* the source is allocated at its exact size, a read past it is caught by the sanitized builds */
+bool findRows(const std::vector<std::uint8_t> &source, std::size_t rowSize, std::size_t numRows,
+              std::vector<std::size_t> &offsets) {
+  return ByteRun1::findRows({source.data(), source.size()}, rowSize, numRows, offsets);
+}
+}// namespace
+
+int main() {
+  std::vector<std::size_t> offsets;
+  // 2 rows of 4 bytes: 4 literals, then a run of 4 then nothing
+  auto ok = check(findRows({3, 1, 2, 3, 4, 0xfd, 7}, 4, 2, offsets) && offsets == std::vector<std::size_t>{0, 5, 7},
+                  "the rows of a whole source are found");
+  // a literal run of 6 bytes with 2 of them in the source, the row goes on after it
+  ok = check(!findRows({5, 1, 2}, 8, 1, offsets), "a truncated literal run is rejected") && ok;
+  ok = check(!findRows({1, 9, 0xff}, 2, 2, offsets), "a run without its byte is rejected") && ok;
+  ok = check(!findRows({0x80}, 2, 1, offsets), "a source ending with a NOOP is rejected") && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,40 @@
+#include "IffReader.h"
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+/* a FORM may count the pad byte of its odd last chunk without the file holding it, not any other missing byte */
+namespace {
+bool check(bool condition, const char *what) {
+  if (!condition)
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  return condition;
+}
+
+/* the number of chunks of a FORM of formLength holding a chunk of chunkLength, -1 when it throws */
+int countChunks(std::uint8_t formLength, std::uint8_t chunkLength) {
+  std::vector<std::uint8_t> data{'F', 'O', 'R', 'M', 0, 0, 0, formLength, 'P', 'B', 'M', ' '};
+  data.insert(data.end(), {'A', 'N', 'N', 'O', 0, 0, 0, chunkLength});
+  data.insert(data.end(), chunkLength, 'x');
+  try {
+    IffReader reader({data.data(), data.size()});
+    IffChunk chunk;
+    auto count = 0;
+    while (reader.next(chunk)) {
+      count++;
+    }
+    return count;
+  } catch (const std::runtime_error &) {
+    return -1;
+  }
+}
+}// namespace
+
+int main() {
+  auto ok = check(countChunks(4 + 8 + 3, 3) == 1, "a FORM without its pad is read");
+  ok = check(countChunks(4 + 8 + 4, 3) == 1, "the missing pad byte of an odd last chunk is allowed") && ok;
+  ok = check(countChunks(4 + 8 + 5, 4) == -1, "a missing byte after an even last chunk throws") && ok;
+  ok = check(countChunks(4 + 8 + 5, 3) == -1, "2 missing bytes throw") && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,64 @@
+#include "ColorCycler.h"
+#include "SceneFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/* the palettes baked in a .ccyc scene are the ones the cycler copies for the first ticks, the cycling goes on
+ * from them like it would have without them, and the scene keeps the compression of its image */
+namespace {
+constexpr std::size_t NumBakedTicks = 100;
+
+bool check(bool condition, const char *what) {
+  if (!condition)
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  return condition;
+}
+}// namespace
+
+int main() {
+  Ilbm source{};
+  source.header.width = 7;
+  source.header.height = 3;
+  source.header.num_planes = 8;
+  source.header.compression = 1;
+  for (std::size_t i = 0; i < source.palette.size(); i++) {
+    source.palette[i] = static_cast<std::uint8_t>(i * 11);
+  }
+  source.image.assign(source.stride() * source.header.height, 5);
+  source.numCycles = 3;
+  source.cycles[0] = {0, 5000, 1, 4, 19};
+  source.cycles[1] = {0, 0, 1, 20, 30};
+  source.cycles[2] = {0, 12000, 3, 40, 47};
+
+  auto data = std::make_shared<std::vector<std::uint8_t>>(SceneFile::write(source, NumBakedTicks));
+  const auto scene = SceneFile::parse({data->data(), data->size()});
+  Ilbm image{};
+  SceneFile::toIlbm(scene, data, image);
+  auto ok = check(image.header.compression == 1, "the scene keeps the compression");
+  ok = check(image.bakedPalettes.size() == NumBakedTicks * image.palette.size() && image.bakedBlend,
+             "the image has the baked palettes") &&
+       ok;
+
+  // the same scene without its baked palettes, cycled along
+  Ilbm cycled = image;
+  cycled.bakedPalettes = {};
+  ColorCycler bakedCycler, cycler;
+  bakedCycler.setBasePalette(image.palette);
+  cycler.setBasePalette(cycled.palette);
+  auto same = true;
+  for (std::size_t tick = 0; tick < NumBakedTicks * 2; tick++) {
+    bakedCycler.step(image);
+    cycler.step(cycled);
+    same = same && image.palette == cycled.palette;
+  }
+  ok = check(same, "the baked palettes and the ones after them are the cycled ones") && ok;
+
+  // a color changed in the first baked palette shows up: it is copied, not computed
+  (*data)[image.bakedPalettes.data() - data->data()] ^= 0xff;
+  bakedCycler.restart();
+  bakedCycler.step(image);
+  ok = check(image.palette[0] == static_cast<std::uint8_t>(source.palette[0] ^ 0xff), "the first tick is copied") && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,66 @@
+#include "ColorCycler.h"
+#include "IlbmLoader.h"
+#include "IlbmWriter.h"
+#include "SceneFile.h"
+#include "ViewModes.h"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/* a HAM6 image with a CRNG survives the round trip through a .ccyc scene: its indices, ranges and view mode
+ * are kept and its colors follow the cycled palette like the ones of the ILBM it comes from */
+namespace {
+bool check(bool condition, const char *what) {
+  if (!condition)
+    std::fprintf(stderr, "FAILED: %s\n", what);
+  return condition;
+}
+}// namespace
+
+int main() {
+  Ilbm source{};
+  source.header.width = 37;
+  source.header.height = 9;
+  source.header.num_planes = 6;
+  source.header.compression = 1;
+  source.viewMode = CamgHam;
+  for (std::size_t i = 0; i < source.palette.size(); i++) {
+    source.palette[i] = static_cast<std::uint8_t>(i * 37);
+  }
+  source.image.assign(source.stride() * source.header.height, 0);
+  for (std::size_t i = 0; i < source.image.size(); i++) {
+    source.image[i] = static_cast<std::uint8_t>((i * 7 + i / 5) % 64);
+  }
+  source.numCycles = 1;
+  source.cycles[0] = {0, 16384, 1, 2, 9};
+
+  const auto ilbm = IlbmWriter::write(source, IlbmWriter::FormType::Ilbm);
+  auto loaded = IlbmLoader::loadFromMemory({ilbm.data(), ilbm.size()});
+  auto data = std::make_shared<std::vector<std::uint8_t>>(SceneFile::write(*loaded));
+  const auto scene = SceneFile::parse({data->data(), data->size()});
+  Ilbm image{};
+  SceneFile::toIlbm(scene, data, image);
+
+  auto ok = check(!scene.trueColor && scene.viewMode == CamgHam, "the scene keeps the indices and the view mode");
+  ok = check(image.isHam() && image.numCycles == 1 && image.cycles[0].low == 2 && image.cycles[0].high == 9,
+             "the image is HAM with its range") && ok;
+  const auto indices = image.pixels();
+  ok = check(std::vector<std::uint8_t>(indices.begin(), indices.end()) == loaded->image, "the indices are the same") && ok;
+  ok = check(image.rgb == loaded->rgb, "the colors are resolved on load") && ok;
+
+  // cycled the same way, the colors stay the same and change
+  ColorCycler loadedCycler, sceneCycler;
+  loadedCycler.setBasePalette(loaded->palette);
+  sceneCycler.setBasePalette(image.palette);
+  const auto first = image.rgb;
+  for (auto tick = 0; tick < 30; tick++) {
+    loadedCycler.step(*loaded);
+    sceneCycler.step(image);
+  }
+  ViewModes::resolveHam(*loaded);
+  ViewModes::resolveHam(image);
+  ok = check(image.rgb == loaded->rgb, "the cycled colors are the same") && ok;
+  ok = check(image.rgb != first, "the range cycles the colors") && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
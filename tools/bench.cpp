@@ -0,0 +1,353 @@
+#include "ByteRun1.h"
+#include "ColorCycler.h"
+#include "IffReader.h"
+#include "IlbmLoader.h"
+#include "IlbmWriter.h"
+#include "MappedFile.h"
+#include "PaletteExpand.h"
+#include "Planar.h"
+#include "SceneGenerator.h"
+#include "Statistics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::vector<std::string> files;
+  std::string filter;
+  int samples{25};
+  double sampleMs{10};
+  bool csv{false};
+};
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations{0};
+  Summary nsPerOp;
+  double bytesPerOp{0};
+};
+
+/* keeps the compiler from optimizing a computed value away */
+template<typename T>
+inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "g"(&value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+class Bench {
+public:
+  explicit Bench(const Options &options) : m_options(options) {}
+
+  /* times op, which processes bytesPerOp bytes per call (0 when it doesn't make sense) */
+  void run(const std::string &name, double bytesPerOp, const std::function<void()> &op) {
+    if (!m_options.filter.empty() && name.find(m_options.filter) == std::string::npos)
+      return;
+
+    // calibrate the number of iterations so that a sample lasts about sampleMs
+    std::uint64_t iterations = 1;
+    for (;;) {
+      auto elapsed = time(op, iterations);
+      if (elapsed >= m_options.sampleMs * 1e6 || iterations >= (1ull << 30))
+        break;
+      auto scale = elapsed > 0 ? m_options.sampleMs * 1e6 / elapsed : 100.0;
+      iterations = std::max<std::uint64_t>(iterations + 1, static_cast<std::uint64_t>(static_cast<double>(iterations) * std::min(scale * 1.1, 100.0)));
+    }
+
+    std::vector<double> samples;
+    for (auto i = 0; i < m_options.samples; i++) {
+      samples.push_back(time(op, iterations) / static_cast<double>(iterations));
+    }
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = Statistics::summarize(samples);
+    result.bytesPerOp = bytesPerOp;
+    print(result);
+  }
+
+  void printHeader() const {
+    if (m_options.csv) {
+      std::printf("name,iterations,mean_ns,p50_ns,p90_ns,p99_ns,min_ns,max_ns,bytes_per_s\n");
+    } else {
+      std::printf("%-36s %12s %12s %12s %12s %12s %8s %12s\n", "benchmark", "iterations", "ns/op(p50)", "p90", "p99", "min", "spread", "MB/s");
+    }
+  }
+
+private:
+  static double time(const std::function<void()> &op, std::uint64_t iterations) {
+    auto start = Clock::now();
+    for (std::uint64_t i = 0; i < iterations; i++)
+      op();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+
+  void print(const Result &result) const {
+    const auto &ns = result.nsPerOp;
+    auto bytesPerSecond = result.bytesPerOp > 0 ? result.bytesPerOp * 1e9 / ns.p50 : 0.0;
+    if (m_options.csv) {
+      std::printf("%s,%llu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.0f\n", result.name.c_str(), static_cast<unsigned long long>(result.iterations),
+                  ns.mean, ns.p50, ns.p90, ns.p99, ns.min, ns.max, bytesPerSecond);
+    } else {
+      // spread is the distance between the p99 and the median, relative to the median
+      auto spread = ns.p50 > 0 ? (ns.p99 - ns.p50) * 100.0 / ns.p50 : 0.0;
+      std::printf("%-36s %12llu %12.1f %12.1f %12.1f %12.1f %7.1f%% ", result.name.c_str(), static_cast<unsigned long long>(result.iterations),
+                  ns.p50, ns.p90, ns.p99, ns.min, spread);
+      if (bytesPerSecond > 0) {
+        std::printf("%12.1f\n", bytesPerSecond / 1e6);
+      } else {
+        std::printf("%12s\n", "-");
+      }
+    }
+    std::fflush(stdout);
+  }
+
+private:
+  const Options &m_options;
+};
+
+void usage() {
+  std::cerr << "usage: colorcycling_bench [options] [file.lbm|directory...]\n"
+               "Times the loader, the planar conversion, the cycling engine and the palette expansion.\n"
+               "Directories are searched for .lbm files (see colorcycling-lbmgen --corpus),\n"
+               "without files a synthetic 640x480 scene is used.\n"
+               "  --filter TEXT   only run the benchmarks whose name contains TEXT\n"
+               "  --samples N     number of timed samples per benchmark (default 25)\n"
+               "  --sample-ms MS  target duration of a sample (default 10)\n"
+               "  --csv           CSV output, to compare runs\n";
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if (arg == "--filter" && hasValue) {
+      options.filter = argv[++i];
+    } else if (arg == "--samples" && hasValue) {
+      options.samples = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--sample-ms" && hasValue) {
+      options.sampleMs = std::max(0.01, std::atof(argv[++i]));
+    } else if (arg == "--csv") {
+      options.csv = true;
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (std::filesystem::is_directory(arg)) {
+      std::vector<std::string> files;
+      for (const auto &entry : std::filesystem::directory_iterator(arg)) {
+        auto extension = entry.path().extension().string();
+        if (entry.is_regular_file() && (extension == ".lbm" || extension == ".LBM"))
+          files.push_back(entry.path().string());
+      }
+      std::sort(files.begin(), files.end());
+      options.files.insert(options.files.end(), files.begin(), files.end());
+    } else {
+      options.files.push_back(arg);
+    }
+  }
+  return true;
+}
+
+void benchLoad(Bench &bench, const std::string &name, const std::string &path) {
+  auto image = IlbmLoader::load(path);
+  bench.run("load/" + name, static_cast<double>(image->pixels().size()), [&path] {
+    auto decoded = IlbmLoader::load(path);
+    doNotOptimize(decoded);
+  });
+}
+
+/* the byte-at-a-time ByteRun1 loop the loader used before ByteRun1::decode, kept as the baseline */
+std::size_t decodeByteRun1Legacy(Span<const std::uint8_t> source, std::uint8_t *destination, std::size_t size) {
+  std::size_t in = 0, out = 0;
+  while (in < source.size() && out < size) {
+    auto n = static_cast<std::int8_t>(source[in++]);
+    if (n >= 0) {
+      for (auto j = 0; j <= n && in < source.size() && out < size; j++) {
+        destination[out++] = source[in++];
+      }
+    } else if (n != -128) {
+      if (in == source.size())
+        break;
+      auto value = source[in++];
+      for (auto j = 0; j < 1 - n && out < size; j++) {
+        destination[out++] = value;
+      }
+    }
+  }
+  return out;
+}
+
+void benchByteRun1(Bench &bench, const std::string &name, const std::string &path) {
+  MappedFile file(path);
+  IffReader reader(file.getData());
+  IffChunk chunk, body;
+  std::size_t rowSize = 0, numRows = 0;
+  while (reader.next(chunk)) {
+    if (chunk.is("BMHD") && chunk.data.size() >= 4) {
+      rowSize = static_cast<std::size_t>(readU16(chunk.data, 0) + 1) / 2 * 2;
+      numRows = readU16(chunk.data, 2);
+    } else if (chunk.is("BODY")) {
+      body = chunk;
+    }
+  }
+  const auto size = rowSize * numRows;
+  if (body.data.empty() || size == 0)
+    return;
+  std::vector<std::uint8_t> out(size);
+  bench.run("byterun1/legacy/" + name, static_cast<double>(size), [&] {
+    decodeByteRun1Legacy(body.data, out.data(), out.size());
+    doNotOptimize(out);
+  });
+  bench.run("byterun1/bulk/" + name, static_cast<double>(size), [&] {
+    ByteRun1::decode(body.data, out.data(), out.size());
+    doNotOptimize(out);
+  });
+  // the scan done before decoding the rows in parallel
+  std::vector<std::size_t> offsets;
+  bench.run("byterun1/rows/" + name, static_cast<double>(size), [&] {
+    auto found = ByteRun1::findRows(body.data, rowSize, numRows, offsets);
+    doNotOptimize(found);
+  });
+}
+
+/* the bit-at-a-time conversion, kept as the baseline of the planar conversions */
+void toChunkyNaive(const std::uint8_t *const *planes, int numPlanes, std::size_t width, std::uint8_t *chunky) {
+  for (std::size_t x = 0; x < width; x++) {
+    std::uint8_t value = 0;
+    for (auto p = 0; p < numPlanes; p++) {
+      if (planes[p][x / 8] & (0x80 >> (x % 8)))
+        value |= static_cast<std::uint8_t>(1 << p);
+    }
+    chunky[x] = value;
+  }
+}
+
+/* bitplanes to chunky conversion of 8 planes of random bits */
+void benchPlanar(Bench &bench, std::size_t width, std::size_t height) {
+  const auto lineSize = Planar::getLineSize(width);
+  std::vector<std::uint8_t> planar(lineSize * 8 * height), out(width * height);
+  std::uint32_t random = 1;
+  for (auto &byte : planar) {
+    random = random * 1664525u + 1013904223u;
+    byte = static_cast<std::uint8_t>(random >> 24);
+  }
+  using Convert = void (*)(const std::uint8_t *const *, int, std::size_t, std::uint8_t *);
+  const std::pair<const char *, Convert> conversions[] = {{"naive", toChunkyNaive}, {"swar", Planar::toChunkySwar}, {"simd", Planar::toChunky}};
+  for (const auto &[name, convert] : conversions) {
+    bench.run(std::string("planar/") + name + "/" + std::to_string(width) + "x" + std::to_string(height), static_cast<double>(out.size()), [&, convert = convert] {
+      const std::uint8_t *planes[8];
+      for (std::size_t y = 0; y < height; y++) {
+        for (auto p = 0; p < 8; p++) {
+          planes[p] = planar.data() + (y * 8 + p) * lineSize;
+        }
+        convert(planes, 8, width, out.data() + y * width);
+      }
+      doNotOptimize(out);
+    });
+  }
+}
+
+void benchCycling(Bench &bench, const std::string &name, const Ilbm &scene) {
+  for (auto blend : {true, false}) {
+    auto image = std::make_unique<Ilbm>(scene);
+    ColorCycler cycler;
+    cycler.setBasePalette(image->palette);
+    cycler.setBlend(blend);
+    bench.run(std::string(blend ? "step/blend/" : "step/noblend/") + name, 0, [&] {
+      cycler.step(*image);
+      doNotOptimize(image->palette);
+    });
+  }
+}
+
+void benchExpand(Bench &bench, const std::string &name, const Ilbm &image) {
+  const auto defaultKernel = PaletteExpand::getKernel();
+  const auto pixels = image.pixels();
+  const auto numPixels = pixels.size();
+  std::vector<std::uint8_t> out(numPixels * 4);
+  for (auto kernel : {PaletteExpand::Kernel::Scalar, PaletteExpand::Kernel::Sse41, PaletteExpand::Kernel::Avx2, PaletteExpand::Kernel::Avx512Vbmi}) {
+    if (!PaletteExpand::setKernel(kernel))
+      continue;
+    auto kernelName = std::string(PaletteExpand::getKernelName(kernel)) + "/" + name;
+    bench.run("expand/rgb/" + kernelName, static_cast<double>(numPixels * 3), [&] {
+      PaletteExpand::toRgb(pixels.data(), numPixels, image.palette.data(), out.data());
+      doNotOptimize(out);
+    });
+    bench.run("expand/rgba/" + kernelName, static_cast<double>(numPixels * 4), [&] {
+      PaletteExpand::toRgba(pixels.data(), numPixels, image.palette.data(), out.data());
+      doNotOptimize(out);
+    });
+  }
+  PaletteExpand::setKernel(defaultKernel);
+}
+
+void benchCycleOffset(Bench &bench) {
+  const std::pair<int, const char *> modes[] = {
+      {CYCLE_NORMAL, "normal"}, {CYCLE_REVERSE, "reverse"}, {CYCLE_PINGPONG, "pingpong"}, {CYCLE_SINE, "sine"}, {CYCLE_SINE_HALF, "sine_half"}};
+  for (const auto &[mode, modeName] : modes) {
+    std::int32_t msec = 0;
+    bench.run(std::string("cycleOffset/") + modeName, 0, [&, mode = mode] {
+      auto offs = cycleOffset(mode, 8192, 32, msec, 1.f);
+      msec += 16;
+      doNotOptimize(offs);
+    });
+  }
+}
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  Bench bench(options);
+  if (!options.csv) {
+    std::printf("expansion kernel: %s\n", PaletteExpand::getKernelName(PaletteExpand::getKernel()));
+  }
+  bench.printHeader();
+
+  try {
+    benchCycleOffset(bench);
+    benchPlanar(bench, 640, 480);
+    if (options.files.empty()) {
+      SceneParameters parameters;
+      parameters.numCycles = 6;
+      parameters.rangeSize = 32;
+      auto scene = SceneGenerator::generate(parameters);
+      auto path = (std::filesystem::temp_directory_path() / "colorcycling_bench.lbm").string();
+      IlbmWriter::save(*scene, path);
+      benchLoad(bench, "synthetic", path);
+      benchByteRun1(bench, "synthetic", path);
+      benchCycling(bench, "synthetic", *scene);
+      benchExpand(bench, "synthetic", *scene);
+      std::filesystem::remove(path);
+    }
+    for (const auto &path : options.files) {
+      auto name = std::filesystem::path(path).filename().string();
+      auto image = IlbmLoader::load(path);
+      benchLoad(bench, name, path);
+      benchByteRun1(bench, name, path);
+      benchCycling(bench, name, *image);
+      benchExpand(bench, name, *image);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include "SceneFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+struct Options {
+  std::vector<std::string> inputs;
+  std::string output;
+  long bakedTicks{0};
+  bool bakedBlend{true};
+  bool info{false};
+};
+
+void usage() {
+  std::cerr << "usage: colorcycling-ccyc [options] <file.lbm>...\n"
+               "       colorcycling-ccyc --info <file.ccyc>...\n"
+               "Converts images to pre-decoded .ccyc scenes, written next to them with the .ccyc extension.\n"
+               "  -o, --output PATH   output file, for a single input\n"
+               "      --bake N        stores the palettes of the first N cycling ticks (speed 1)\n"
+               "      --no-blend      bakes the palettes without the blending between cycled colors\n"
+               "      --info          prints the content of .ccyc scenes\n";
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if ((arg == "-o" || arg == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if (arg == "--bake" && hasValue) {
+      options.bakedTicks = std::strtol(argv[++i], nullptr, 10);
+    } else if (arg == "--no-blend") {
+      options.bakedBlend = false;
+    } else if (arg == "--info") {
+      options.info = true;
+    } else if (arg[0] == '-') {
+      return false;
+    } else {
+      options.inputs.push_back(arg);
+    }
+  }
+  return !options.inputs.empty() && options.bakedTicks >= 0 && (options.output.empty() || options.inputs.size() == 1);
+}
+
+void printInfo(const std::string &path) {
+  MappedFile file(path);
+  SceneFile::Scene scene;
+  try {
+    scene = SceneFile::parse(file.getData());
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error(path + ": " + e.what());
+  }
+  std::printf("%s: %dx%d, %s, compression %d, %zu ranges, %zu baked ticks%s\n", path.c_str(), scene.header.width,
+              scene.header.height, scene.trueColor ? "RGB" : (scene.viewMode & CamgHam) ? "HAM indexed" : "indexed",
+              scene.header.compression, scene.ranges.size(), scene.numBakedTicks,
+              scene.numBakedTicks ? (scene.bakedBlend ? " (blend)" : " (no blend)") : "");
+  for (const auto &range : scene.ranges) {
+    std::printf("  [%3d, %3d] mode %d rate %6d\n", range.low, range.high, range.mode, range.rate);
+  }
+}
+
+void convert(const std::string &input, const std::string &output, const Options &options) {
+  const auto image = IlbmLoader::load(input);
+  SceneFile::save(*image, output, static_cast<std::size_t>(options.bakedTicks), options.bakedBlend);
+  std::printf("%s -> %s (%llu bytes)\n", input.c_str(), output.c_str(),
+              static_cast<unsigned long long>(std::filesystem::file_size(output)));
+}
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  auto ok = true;
+  for (const auto &input : options.inputs) {
+    try {
+      if (options.info) {
+        printInfo(input);
+      } else {
+        convert(input, options.output.empty() ? std::filesystem::path(input).replace_extension(".ccyc").string() : options.output, options);
+      }
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      ok = false;
+    }
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,310 @@
+#include "ColorCycler.h"
+#include "IlbmLoader.h"
+#include "PaletteExpand.h"
+#include "SceneGenerator.h"
+#include "Util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+enum class Mode { Record, Verify };
+
+struct Options {
+  Mode mode{Mode::Verify};
+  std::string golden;
+  std::vector<std::string> files;
+  int ticks{600};
+  int tolerance{1};
+};
+
+/* a fixed tick sequence on a scene */
+struct Run {
+  const char *name;
+  bool blend;
+  float speed;
+};
+
+constexpr Run Runs[] = {{"blend", true, 1.f}, {"noblend", false, 1.f}, {"blend_x2.5", true, 2.5f}};
+
+struct Scene {
+  std::string name;
+  std::unique_ptr<Ilbm> image;
+};
+
+void expand(const Ilbm &image, PaletteExpand::Kernel kernel, std::vector<std::uint8_t> &rgb) {
+  const auto defaultKernel = PaletteExpand::getKernel();
+  PaletteExpand::setKernel(kernel);
+  PaletteExpand::toRgb(image.pixels().data(), image.pixels().size(), image.palette.data(), rgb.data());
+  PaletteExpand::setKernel(defaultKernel);
+}
+
+/* an optimized path producing the RGB frames of the reference engine followed by the scalar expansion */
+class Variant {
+public:
+  virtual ~Variant() = default;
+
+  [[nodiscard]] virtual std::string getName() const = 0;
+  virtual void reset(const Ilbm &scene, const Run &run) = 0;
+  virtual void tick(std::vector<std::uint8_t> &rgb) = 0;
+};
+
+/* one of the palette expansion kernels behind the reference engine */
+class ExpandVariant final : public Variant {
+public:
+  explicit ExpandVariant(PaletteExpand::Kernel kernel) : m_kernel(kernel) {}
+
+  [[nodiscard]] std::string getName() const override {
+    return std::string("expand/") + PaletteExpand::getKernelName(m_kernel);
+  }
+
+  void reset(const Ilbm &scene, const Run &run) override {
+    m_image = std::make_unique<Ilbm>(scene);
+    m_cycler = ColorCycler();
+    m_cycler.setBasePalette(m_image->palette);
+    m_cycler.setBlend(run.blend);
+    m_cycler.setSpeed(run.speed);
+  }
+
+  void tick(std::vector<std::uint8_t> &rgb) override {
+    m_cycler.step(*m_image);
+    expand(*m_image, m_kernel, rgb);
+  }
+
+private:
+  PaletteExpand::Kernel m_kernel;
+  std::unique_ptr<Ilbm> m_image;
+  ColorCycler m_cycler;
+};
+
+std::vector<std::unique_ptr<Variant>> createVariants() {
+  std::vector<std::unique_ptr<Variant>> variants;
+  for (auto kernel : {PaletteExpand::Kernel::Sse41, PaletteExpand::Kernel::Avx2, PaletteExpand::Kernel::Avx512Vbmi}) {
+    if (PaletteExpand::isSupported(kernel))
+      variants.push_back(std::make_unique<ExpandVariant>(kernel));
+  }
+  return variants;
+}
+
+void usage() {
+  std::cerr << "usage: colorcycling-hashcheck --record|--verify <hashes.txt> [options] [file.lbm|directory...]\n"
+               "Steps the cycling engine for a fixed tick sequence and hashes the palette after each tick.\n"
+               "--record writes the hashes of the reference engine, --verify checks the engine against them\n"
+               "and checks every optimized variant against the reference engine. Without files a synthetic\n"
+               "corpus covering all the cycling modes is used.\n"
+               "  --ticks N        number of ticks per run (default 600)\n"
+               "  --tolerance N    maximal difference of a channel allowed to the variants in the\n"
+               "                   blended runs (default 1), the runs without blending must be bit-exact\n";
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if ((arg == "--record" || arg == "--verify") && hasValue) {
+      options.mode = arg == "--record" ? Mode::Record : Mode::Verify;
+      options.golden = argv[++i];
+    } else if (arg == "--ticks" && hasValue) {
+      options.ticks = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--tolerance" && hasValue) {
+      options.tolerance = std::max(0, std::atoi(argv[++i]));
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (std::filesystem::is_directory(arg)) {
+      std::vector<std::string> files;
+      for (const auto &entry : std::filesystem::directory_iterator(arg)) {
+        auto extension = entry.path().extension().string();
+        if (entry.is_regular_file() && (extension == ".lbm" || extension == ".LBM"))
+          files.push_back(entry.path().string());
+      }
+      std::sort(files.begin(), files.end());
+      options.files.insert(options.files.end(), files.begin(), files.end());
+    } else {
+      options.files.push_back(arg);
+    }
+  }
+  return !options.golden.empty();
+}
+
+std::vector<Scene> loadScenes(const Options &options) {
+  std::vector<Scene> scenes;
+  if (options.files.empty()) {
+    // small scenes, every mode with several rates and range sizes
+    const int modes[] = {CYCLE_NORMAL, CYCLE_REVERSE, CYCLE_PINGPONG, CYCLE_SINE_HALF, CYCLE_SINE};
+    for (auto mode : modes) {
+      for (auto rangeSize : {2, 16, 64}) {
+        SceneParameters parameters;
+        parameters.width = 64;
+        parameters.height = 48;
+        parameters.seed = static_cast<std::uint32_t>(mode * 100 + rangeSize);
+        parameters.numCycles = 4;
+        parameters.rangeSize = rangeSize;
+        parameters.modes = {mode};
+        std::ostringstream name;
+        name << "synthetic_mode" << mode << "_r" << rangeSize;
+        scenes.push_back({name.str(), SceneGenerator::generate(parameters)});
+      }
+    }
+    return scenes;
+  }
+  for (const auto &path : options.files) {
+    scenes.push_back({std::filesystem::path(path).filename().string(), IlbmLoader::load(path)});
+  }
+  return scenes;
+}
+
+std::string formatHash(std::uint64_t hash) {
+  char text[17];
+  std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+  return text;
+}
+
+std::string getKey(const Scene &scene, const Run &run, int tick) {
+  std::ostringstream key;
+  key << scene.name << ' ' << run.name << ' ' << tick;
+  return key.str();
+}
+
+/* "<scene> <run> <tick>" -> hash */
+std::map<std::string, std::string> readGolden(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::ostringstream ss;
+    ss << "Error when opening " << path;
+    throw std::runtime_error(ss.str());
+  }
+  std::map<std::string, std::string> hashes;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    auto pos = line.rfind(' ');
+    if (pos == std::string::npos)
+      continue;
+    hashes[line.substr(0, pos)] = line.substr(pos + 1);
+  }
+  return hashes;
+}
+
+/* largest difference between two frames, 256 when they have different sizes */
+int getMaxDifference(const std::vector<std::uint8_t> &a, const std::vector<std::uint8_t> &b) {
+  if (a.size() != b.size())
+    return 256;
+  auto difference = 0;
+  for (std::size_t i = 0; i < a.size(); i++) {
+    difference = std::max(difference, std::abs(a[i] - b[i]));
+  }
+  return difference;
+}
+
+class Checker {
+public:
+  explicit Checker(const Options &options) : m_options(options), m_variants(createVariants()) {
+    if (options.mode == Mode::Verify) {
+      m_golden = readGolden(options.golden);
+    } else {
+      m_output.open(options.golden);
+      if (!m_output) {
+        std::ostringstream ss;
+        ss << "Error when opening " << options.golden;
+        throw std::runtime_error(ss.str());
+      }
+      m_output << "# palette hashes (FNV-1a 64) after each tick: <scene> <run> <tick> <hash>\n";
+    }
+  }
+
+  void check(const Scene &scene) {
+    for (const auto &run : Runs) {
+      checkRun(scene, run);
+    }
+  }
+
+  [[nodiscard]] int getNumFailures() const { return m_numFailures; }
+
+private:
+  void checkRun(const Scene &scene, const Run &run) {
+    auto image = std::make_unique<Ilbm>(*scene.image);
+    ColorCycler cycler;
+    cycler.setBasePalette(image->palette);
+    cycler.setBlend(run.blend);
+    cycler.setSpeed(run.speed);
+    for (auto &variant : m_variants) {
+      variant->reset(*scene.image, run);
+    }
+
+    const auto tolerance = run.blend ? m_options.tolerance : 0;
+    std::vector<std::uint8_t> reference(image->pixels().size() * 3), rgb(reference.size());
+    std::vector<bool> failed(m_variants.size());
+    auto goldenFailed = false;
+    for (auto tick = 0; tick < m_options.ticks; tick++) {
+      cycler.step(*image);
+      auto hash = formatHash(Util::hash64(image->palette.data(), image->palette.size()));
+      auto key = getKey(scene, run, tick);
+      if (m_options.mode == Mode::Record) {
+        m_output << key << ' ' << hash << '\n';
+      } else if (!goldenFailed) {
+        auto it = m_golden.find(key);
+        if (it == m_golden.end() || it->second != hash) {
+          std::cout << "FAIL engine " << key << ": " << hash << ", expected " << (it == m_golden.end() ? "no hash" : it->second) << std::endl;
+          goldenFailed = true;
+          m_numFailures++;
+        }
+      }
+
+      expand(*image, PaletteExpand::Kernel::Scalar, reference);
+      for (std::size_t i = 0; i < m_variants.size(); i++) {
+        if (failed[i])
+          continue;
+        m_variants[i]->tick(rgb);
+        auto difference = getMaxDifference(reference, rgb);
+        if (difference > tolerance) {
+          std::cout << "FAIL " << m_variants[i]->getName() << ' ' << key << ": channel difference " << difference << " > " << tolerance << std::endl;
+          failed[i] = true;
+          m_numFailures++;
+        }
+      }
+    }
+    std::cout << (goldenFailed || std::find(failed.begin(), failed.end(), true) != failed.end() ? "failed " : "ok     ")
+              << scene.name << ' ' << run.name << std::endl;
+  }
+
+private:
+  const Options &m_options;
+  std::vector<std::unique_ptr<Variant>> m_variants;
+  std::map<std::string, std::string> m_golden;
+  std::ofstream m_output;
+  int m_numFailures{0};
+};
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  try {
+    Checker checker(options);
+    for (const auto &scene : loadScenes(options)) {
+      checker.check(scene);
+    }
+    if (checker.getNumFailures() > 0) {
+      std::cout << checker.getNumFailures() << " failure(s)" << std::endl;
+      return EXIT_FAILURE;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
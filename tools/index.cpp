@@ -0,0 +1,191 @@
+#include "ColorCycler.h"
+#include "SceneIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+struct Options {
+  std::vector<std::string> inputs;
+  std::string output;
+  std::string query;
+  long numThreads{16};
+  SceneIndex::Query filters;
+  bool duplicates{false};
+};
+
+const std::pair<const char *, int> Modes[] = {
+    {"normal", CYCLE_NORMAL}, {"reverse", CYCLE_REVERSE}, {"pingpong", CYCLE_PINGPONG}, {"sine", CYCLE_SINE}, {"sine_half", CYCLE_SINE_HALF}};
+
+void usage() {
+  std::cerr << "usage: colorcycling-index [options] -o <index.ccix> <directory or file>...\n"
+               "       colorcycling-index --query <index.ccix> [filters]\n"
+               "Indexes the chunks before the body of the .lbm/.ilbm/.iff/.anm/.anim files of directories (recursively),\n"
+               "without reading the bodies. An existing index is updated, the unchanged files are not read again.\n"
+               "  -o, --output PATH   index file to write\n"
+               "  -j, --threads N     files read at the same time (default 16)\n"
+               "      --query PATH    prints the entries of an index matching the filters\n"
+               "filters:\n"
+               "      --min-width W, --max-width W, --min-height H, --max-height H\n"
+               "      --planes N      number of bitplanes (24 for deep images)\n"
+               "      --compression N 0 (none), 1 (ByteRun1) or 2 (vertical RLE)\n"
+               "      --min-cycles N  number of active cycling ranges\n"
+               "      --mode NAME     has ranges of this mode (normal, reverse, pingpong, sine, sine_half), repeatable\n"
+               "      --form TYPE     PBM, ILBM, ACBM or ANIM\n"
+               "      --duplicates    only the files whose chunks before the body are the same as another one's\n";
+}
+
+bool parseMode(const std::string &name, std::uint16_t &modes) {
+  for (const auto &[modeName, mode] : Modes) {
+    if (name == modeName) {
+      modes |= static_cast<std::uint16_t>(1u << mode);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  auto &filters = options.filters;
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if ((arg == "-o" || arg == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if ((arg == "-j" || arg == "--threads") && hasValue) {
+      options.numThreads = std::strtol(argv[++i], nullptr, 10);
+    } else if (arg == "--query" && hasValue) {
+      options.query = argv[++i];
+    } else if (arg == "--min-width" && hasValue) {
+      filters.minWidth = std::atoi(argv[++i]);
+    } else if (arg == "--max-width" && hasValue) {
+      filters.maxWidth = std::atoi(argv[++i]);
+    } else if (arg == "--min-height" && hasValue) {
+      filters.minHeight = std::atoi(argv[++i]);
+    } else if (arg == "--max-height" && hasValue) {
+      filters.maxHeight = std::atoi(argv[++i]);
+    } else if (arg == "--planes" && hasValue) {
+      filters.numPlanes = std::atoi(argv[++i]);
+    } else if (arg == "--compression" && hasValue) {
+      filters.compression = std::atoi(argv[++i]);
+    } else if (arg == "--min-cycles" && hasValue) {
+      filters.minCycles = std::atoi(argv[++i]);
+    } else if (arg == "--mode" && hasValue) {
+      if (!parseMode(argv[++i], filters.cycleModes))
+        return false;
+    } else if (arg == "--form" && hasValue) {
+      filters.formType = argv[++i];
+    } else if (arg == "--duplicates") {
+      options.duplicates = true;
+    } else if (arg[0] == '-') {
+      return false;
+    } else {
+      options.inputs.push_back(arg);
+    }
+  }
+  if (!options.query.empty())
+    return options.inputs.empty() && options.output.empty();
+  return !options.inputs.empty() && !options.output.empty() && options.numThreads > 0;
+}
+
+bool isImage(const std::filesystem::path &path) {
+  auto extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+  return extension == ".lbm" || extension == ".ilbm" || extension == ".iff" || extension == ".anm" || extension == ".anim";
+}
+
+/* the image files of the inputs, the directories are walked recursively */
+std::vector<std::string> listImages(const std::vector<std::string> &inputs) {
+  std::vector<std::string> paths;
+  for (const auto &input : inputs) {
+    if (!std::filesystem::is_directory(input)) {
+      paths.push_back(input);
+      continue;
+    }
+    const auto options = std::filesystem::directory_options::skip_permission_denied;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(input, options)) {
+      if (entry.is_regular_file() && isImage(entry.path()))
+        paths.push_back(entry.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+  return paths;
+}
+
+std::string getModes(std::uint16_t modes) {
+  std::string names;
+  for (const auto &[name, mode] : Modes) {
+    if (modes & (1u << mode))
+      names += names.empty() ? name : std::string(",") + name;
+  }
+  return names.empty() ? "-" : names;
+}
+
+int build(const Options &options) {
+  std::vector<SceneIndex::Entry> previous;
+  if (std::filesystem::exists(options.output)) {
+    try {
+      previous = SceneIndex::load(options.output);
+    } catch (const std::runtime_error &e) {
+      std::cerr << e.what() << ", rebuilt" << std::endl;
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto paths = listImages(options.inputs);
+  std::vector<std::string> errors;
+  const auto entries = SceneIndex::build(paths, previous, static_cast<std::size_t>(options.numThreads), errors);
+  const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  for (const auto &error : errors) {
+    std::cerr << error << std::endl;
+  }
+  SceneIndex::save(entries, options.output);
+  std::printf("%s: %zu files indexed, %zu errors, in %.1f ms\n", options.output.c_str(), entries.size(), errors.size(), elapsed);
+  return errors.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int query(const Options &options) {
+  const auto entries = SceneIndex::load(options.query);
+  std::unordered_map<std::uint64_t, std::size_t> numSameHash;
+  if (options.duplicates) {
+    for (const auto &entry : entries) {
+      numSameHash[entry.hash]++;
+    }
+  }
+  std::size_t numMatches = 0;
+  for (const auto &entry : entries) {
+    if (!SceneIndex::matches(entry, options.filters) || (options.duplicates && numSameHash[entry.hash] < 2))
+      continue;
+    numMatches++;
+    std::printf("%s: %.4s %dx%d, %d planes, compression %d, %d colors, %d cycles (%s), %016llx\n", entry.path.c_str(),
+                entry.formType, entry.width, entry.height, entry.numPlanes, entry.compression, entry.numColors,
+                entry.numCycles, getModes(entry.cycleModes).c_str(), static_cast<unsigned long long>(entry.hash));
+  }
+  std::printf("%zu of %zu entries\n", numMatches, entries.size());
+  return EXIT_SUCCESS;
+}
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  try {
+    return options.query.empty() ? build(options) : query(options);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,275 @@
+#include "ColorCycler.h"
+#include "IlbmWriter.h"
+#include "PaletteExpand.h"
+#include "SceneGenerator.h"
+#include "Thumbnails.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+/* the CAMG mode of the scene and its number of planes, the indices are cut to them */
+struct View {
+  std::uint32_t mode{0};
+  int numPlanes{8};
+};
+
+/* the frames of an ANIM, none for a still image */
+struct Frames {
+  int count{0};
+  IlbmWriter::Delta delta{IlbmWriter::Delta::Byte};
+};
+
+struct Options {
+  SceneParameters scene;
+  IlbmWriter::FormType formType{IlbmWriter::FormType::Pbm};
+  bool deep{false};
+  bool verticalRle{false};
+  bool tiny{false};
+  View view;
+  Frames frames;
+  std::string output;
+  std::string corpus;
+};
+
+void usage() {
+  std::cerr << "usage: colorcycling-lbmgen [options] <output.lbm>\n"
+               "       colorcycling-lbmgen --corpus <directory>\n"
+               "Writes reproducible synthetic PBM/ILBM/ACBM scenes.\n"
+               "  --width W          width in pixels (default 640)\n"
+               "  --height H         height in pixels (default 480)\n"
+               "  --seed N           random seed (default 1)\n"
+               "  --runs F           share of the pixels in runs from 0 (noise, literal-heavy) to 1 (default 0.5)\n"
+               "  --run-length N     mean length of the runs and noise segments (default 32)\n"
+               "  --cycles N         number of CRNG ranges (default 4)\n"
+               "  --range-size N     number of colors per range (default 16)\n"
+               "  --modes LIST       comma separated modes among normal, reverse, pingpong, sine, sine_half\n"
+               "  --ilbm             interleaved bitplanes instead of a chunky PBM body\n"
+               "  --acbm             contiguous bitplanes (ABIT chunk, never compressed)\n"
+               "  --deep             24-bit ILBM of the palette-expanded scene, implies --ilbm\n"
+               "  --uncompressed     store the BODY without ByteRun1\n"
+               "  --vertical-rle     vertical RLE (VDAT) BODY instead of ByteRun1, implies --ilbm\n"
+               "  --view MODE        ham6, ham8 (hold-and-modify) or ehb (Extra-Half-Brite) CAMG, implies --ilbm\n"
+               "  --tiny             stores an 80 pixels TINY thumbnail before the BODY\n"
+               "  --anim N           ANIM of N frames of a block moving over the scene, implies --ilbm\n"
+               "  --delta TYPE       byte (operation 5, default), short or long (operation 7) ANIM deltas\n"
+               "  --corpus DIR       writes the standard benchmark corpus into DIR\n";
+}
+
+bool parseModes(const std::string &list, std::vector<int> &modes) {
+  std::istringstream ss(list);
+  std::string mode;
+  while (std::getline(ss, mode, ',')) {
+    if (mode == "normal") {
+      modes.push_back(CYCLE_NORMAL);
+    } else if (mode == "reverse") {
+      modes.push_back(CYCLE_REVERSE);
+    } else if (mode == "pingpong") {
+      modes.push_back(CYCLE_PINGPONG);
+    } else if (mode == "sine") {
+      modes.push_back(CYCLE_SINE);
+    } else if (mode == "sine_half") {
+      modes.push_back(CYCLE_SINE_HALF);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  auto &scene = options.scene;
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if (arg == "--width" && hasValue) {
+      scene.width = static_cast<std::uint16_t>(std::clamp(std::atoi(argv[++i]), 1, 65535));
+    } else if (arg == "--height" && hasValue) {
+      scene.height = static_cast<std::uint16_t>(std::clamp(std::atoi(argv[++i]), 1, 65535));
+    } else if (arg == "--seed" && hasValue) {
+      scene.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--runs" && hasValue) {
+      scene.runFraction = std::strtof(argv[++i], nullptr);
+    } else if (arg == "--run-length" && hasValue) {
+      scene.runLength = std::atoi(argv[++i]);
+    } else if (arg == "--cycles" && hasValue) {
+      scene.numCycles = std::atoi(argv[++i]);
+    } else if (arg == "--range-size" && hasValue) {
+      scene.rangeSize = std::atoi(argv[++i]);
+    } else if (arg == "--modes" && hasValue) {
+      if (!parseModes(argv[++i], scene.modes))
+        return false;
+    } else if (arg == "--ilbm") {
+      options.formType = IlbmWriter::FormType::Ilbm;
+    } else if (arg == "--acbm") {
+      options.formType = IlbmWriter::FormType::Acbm;
+    } else if (arg == "--deep") {
+      options.deep = true;
+    } else if (arg == "--vertical-rle") {
+      options.verticalRle = true;
+    } else if (arg == "--view" && hasValue) {
+      std::string view = argv[++i];
+      if (view == "ham6") {
+        options.view = {CamgHam, 6};
+      } else if (view == "ham8") {
+        options.view = {CamgHam, 8};
+      } else if (view == "ehb") {
+        options.view = {CamgExtraHalfBrite, 6};
+      } else {
+        return false;
+      }
+    } else if (arg == "--anim" && hasValue) {
+      options.frames.count = std::max(std::atoi(argv[++i]), 1);
+    } else if (arg == "--delta" && hasValue) {
+      std::string delta = argv[++i];
+      if (delta == "byte") {
+        options.frames.delta = IlbmWriter::Delta::Byte;
+      } else if (delta == "short") {
+        options.frames.delta = IlbmWriter::Delta::Short;
+      } else if (delta == "long") {
+        options.frames.delta = IlbmWriter::Delta::Long;
+      } else {
+        return false;
+      }
+    } else if (arg == "--tiny") {
+      options.tiny = true;
+    } else if (arg == "--uncompressed") {
+      scene.compress = false;
+    } else if (arg == "--corpus" && hasValue) {
+      options.corpus = argv[++i];
+    } else if (arg[0] == '-' || !options.output.empty()) {
+      return false;
+    } else {
+      options.output = arg;
+    }
+  }
+  return options.output.empty() != options.corpus.empty();
+}
+
+/* replaces the indices by their colors, the scene becomes a 24 planes truecolor image */
+void makeDeep(Ilbm &image) {
+  const auto pixels = image.pixels();
+  image.rgb.resize(pixels.size() * 3);
+  PaletteExpand::toRgb(pixels.data(), pixels.size(), image.palette.data(), image.rgb.data());
+  image.image.clear();
+  image.header.num_planes = 24;
+  image.numCycles = 0;
+}
+
+/* the scene with a square of its top left corner moving to the right, 8 pixels per frame, over its middle */
+std::vector<Ilbm> makeFrames(const Ilbm &image, int count) {
+  const int width = image.header.width, height = image.header.height;
+  const auto size = std::max(1, std::min(width, height) / 4);
+  const auto stride = image.stride();
+  std::vector<Ilbm> frames(static_cast<std::size_t>(count), image);
+  for (auto i = 0; i < count; i++) {
+    const auto left = (i * 8) % std::max(1, width - size + 1);
+    const auto top = (height - size) / 2;
+    for (auto y = 0; y < size; y++) {
+      std::copy_n(image.image.data() + y * stride, size, frames[i].image.data() + (top + y) * stride + left);
+    }
+  }
+  return frames;
+}
+
+void save(const SceneParameters &scene, IlbmWriter::FormType formType, bool deep, bool verticalRle, const std::string &path,
+          bool tiny = false, const View &view = {}, const Frames &frames = {}) {
+  auto image = SceneGenerator::generate(scene);
+  if (view.mode) {
+    for (auto &index : image->image) {
+      index = static_cast<std::uint8_t>(index & ((1 << view.numPlanes) - 1));
+    }
+    image->header.num_planes = static_cast<unsigned char>(view.numPlanes);
+    image->viewMode = view.mode;
+  }
+  if (deep)
+    makeDeep(*image);
+  if (verticalRle)
+    image->header.compression = 2;
+  if ((deep || verticalRle || view.mode) && formType == IlbmWriter::FormType::Pbm)
+    formType = IlbmWriter::FormType::Ilbm;
+  if (frames.count > 0) {
+    IlbmWriter::saveAnim(makeFrames(*image, frames.count), path, frames.delta);
+    std::cout << path << std::endl;
+    return;
+  }
+  const auto thumbnail = tiny ? Thumbnails::downscale(*image, 80) : nullptr;
+  IlbmWriter::save(*image, path, formType, thumbnail.get());
+  std::cout << path << std::endl;
+}
+
+/* sizes, compression ratios and numbers of ranges used to track load and cycling times */
+void writeCorpus(const std::string &directory) {
+  std::filesystem::create_directories(directory);
+  const std::pair<int, int> sizes[] = {{320, 200}, {640, 480}, {1920, 1080}, {4096, 2160}};
+  const float runFractions[] = {0.05f, 0.5f, 0.95f};
+  std::uint32_t seed = 1;
+  for (const auto &[width, height] : sizes) {
+    for (auto runs : runFractions) {
+      SceneParameters scene;
+      scene.width = static_cast<std::uint16_t>(width);
+      scene.height = static_cast<std::uint16_t>(height);
+      scene.seed = seed++;
+      scene.runFraction = runs;
+      scene.numCycles = 8;
+      std::ostringstream name;
+      name << "pbm_" << width << "x" << height << "_runs" << static_cast<int>(runs * 100) << "_c8.lbm";
+      save(scene, IlbmWriter::FormType::Pbm, false, false, (std::filesystem::path(directory) / name.str()).string());
+    }
+  }
+  for (auto numCycles : {0, 1, 16, 64, 255}) {
+    for (auto rangeSize : {4, 32}) {
+      SceneParameters scene;
+      scene.seed = seed++;
+      scene.numCycles = numCycles;
+      scene.rangeSize = rangeSize;
+      std::ostringstream name;
+      name << "pbm_640x480_runs50_c" << numCycles << "_r" << rangeSize << ".lbm";
+      save(scene, IlbmWriter::FormType::Pbm, false, false, (std::filesystem::path(directory) / name.str()).string());
+    }
+  }
+  for (auto compress : {true, false}) {
+    SceneParameters scene;
+    scene.seed = seed++;
+    scene.compress = compress;
+    save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / (compress ? "ilbm_640x480_runs50_c4.lbm" : "ilbm_640x480_raw_c4.lbm")).string());
+    save(scene, IlbmWriter::FormType::Pbm, false, false, (std::filesystem::path(directory) / (compress ? "pbm_640x480_runs50_c4.lbm" : "pbm_640x480_raw_c4.lbm")).string());
+    save(scene, IlbmWriter::FormType::Ilbm, true, false, (std::filesystem::path(directory) / (compress ? "deep_640x480_runs50.lbm" : "deep_640x480_raw.lbm")).string());
+  }
+  SceneParameters scene;
+  scene.seed = seed++;
+  save(scene, IlbmWriter::FormType::Acbm, false, false, (std::filesystem::path(directory) / "acbm_640x480_c4.lbm").string());
+  save(scene, IlbmWriter::FormType::Ilbm, false, true, (std::filesystem::path(directory) / "ilbm_640x480_vrle_c4.lbm").string());
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "ilbm_640x480_tiny_c4.lbm").string(), true);
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "ham6_640x480_c4.lbm").string(), false, {CamgHam, 6});
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "ham8_640x480_c4.lbm").string(), false, {CamgHam, 8});
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "ehb_640x480_c4.lbm").string(), false, {CamgExtraHalfBrite, 6});
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "anim5_640x480_c4.lbm").string(), false, {}, {60, IlbmWriter::Delta::Byte});
+  save(scene, IlbmWriter::FormType::Ilbm, false, false, (std::filesystem::path(directory) / "anim7_640x480_c4.lbm").string(), false, {}, {60, IlbmWriter::Delta::Long});
+}
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  try {
+    if (!options.corpus.empty()) {
+      writeCorpus(options.corpus);
+    } else {
+      save(options.scene, options.formType, options.deep, options.verticalRle, options.output, options.tiny, options.view, options.frames);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+#include "Anim.h"
+#include "ColorCycler.h"
+#include "IlbmLoader.h"
+#include "MappedFile.h"
+#include "PaletteExpand.h"
+#include "ViewModes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int TicksPerSecond = 60;
+
+enum class Format { Raw, Ppm };
+
+struct Options {
+  std::string input;
+  std::string output{"-"};
+  Format format{Format::Raw};
+  long frames{TicksPerSecond};
+  bool blend{true};
+  float speed{1.f};
+};
+
+void usage() {
+  std::cerr << "usage: colorcycling-render [options] <file.lbm>\n"
+               "Renders palette-expanded RGB24 frames, one frame per 1/60 s cycling tick, the frames of ANIM files\n"
+               "are played at their own pace.\n"
+               "  -n, --frames N      number of frames to render (default 60)\n"
+               "  -d, --duration SEC  render SEC seconds of animation\n"
+               "  -f, --format FMT    raw (default) or ppm\n"
+               "  -o, --output PATH   output file, - for stdout (default),\n"
+               "                      a printf pattern such as frame%05d.ppm writes one file per frame\n"
+               "      --no-blend      disable the blending between cycled colors\n"
+               "      --speed X       cycling speed multiplier (default 1)\n";
+}
+
+bool parseArgs(int argc, const char **argv, Options &options) {
+  for (auto i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto hasValue = i + 1 < argc;
+    if ((arg == "-n" || arg == "--frames") && hasValue) {
+      options.frames = std::strtol(argv[++i], nullptr, 10);
+    } else if ((arg == "-d" || arg == "--duration") && hasValue) {
+      options.frames = static_cast<long>(std::strtod(argv[++i], nullptr) * TicksPerSecond);
+    } else if ((arg == "-f" || arg == "--format") && hasValue) {
+      std::string format = argv[++i];
+      if (format == "raw") {
+        options.format = Format::Raw;
+      } else if (format == "ppm") {
+        options.format = Format::Ppm;
+      } else {
+        return false;
+      }
+    } else if ((arg == "-o" || arg == "--output") && hasValue) {
+      options.output = argv[++i];
+    } else if (arg == "--no-blend") {
+      options.blend = false;
+    } else if (arg == "--speed" && hasValue) {
+      options.speed = std::strtof(argv[++i], nullptr);
+    } else if (arg[0] == '-' || !options.input.empty()) {
+      return false;
+    } else {
+      options.input = arg;
+    }
+  }
+  return !options.input.empty() && options.frames >= 0;
+}
+
+/* a pattern output has exactly one printf conversion, which must be an integer one */
+bool isPattern(const std::string &output) {
+  auto pos = output.find('%');
+  if (pos == std::string::npos || output.find('%', pos + 1) != std::string::npos)
+    return false;
+  auto end = output.find_first_not_of("0123456789", pos + 1);
+  return end != std::string::npos && output[end] == 'd';
+}
+
+/* the first width * height pixels of rgb */
+bool writeFrame(FILE *file, const Options &options, int width, int height, const std::vector<std::uint8_t> &rgb) {
+  if (options.format == Format::Ppm) {
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+  }
+  const auto size = static_cast<std::size_t>(width) * height * 3;
+  return std::fwrite(rgb.data(), 1, size, file) == size;
+}
+
+/* drops the padding pixel at the end of the rows of odd width images */
+void removePadding(std::vector<std::uint8_t> &rgb, int width, int height, std::size_t stride) {
+  if (stride == static_cast<std::size_t>(width))
+    return;
+  for (auto y = 1; y < height; y++) {
+    std::memmove(rgb.data() + y * width * 3, rgb.data() + y * stride * 3, static_cast<std::size_t>(width) * 3);
+  }
+}
+}// namespace
+
+int main(int argc, const char **argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  std::unique_ptr<Ilbm> image;
+  std::unique_ptr<Anim> anim;
+  try {
+    auto file = std::make_shared<const MappedFile>(options.input);
+    image = IlbmLoader::load(options.input);
+    if (Anim::isAnim(file->getData())) {
+      try {
+        anim = std::make_unique<Anim>(file, *image);
+      } catch (const std::runtime_error &e) {
+        throw std::runtime_error(options.input + ": " + e.what());
+      }
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  const int width = image->header.width;
+  const int height = image->header.height;
+  const auto stride = image->stride();
+  const auto numPixels = stride * height;
+  if ((image->isTrueColor() ? image->rgb.size() / 3 : image->pixels().size()) < numPixels) {
+    std::cerr << options.input << ": no decodable image body" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // the cycler copies the palettes baked in a scene, reported when they cover the whole run
+  const auto baked = options.frames > 0 &&
+                     static_cast<std::size_t>(options.frames) <= image->bakedPalettes.size() / image->palette.size() &&
+                     options.blend == image->bakedBlend && options.speed == 1.f;
+
+  ColorCycler cycler;
+  cycler.setBasePalette(image->palette);
+  cycler.setBlend(options.blend);
+  cycler.setSpeed(options.speed);
+
+  const auto perFrameFiles = isPattern(options.output);
+  FILE *file = nullptr;
+  if (options.output == "-") {
+    file = stdout;
+  } else if (!perFrameFiles) {
+    file = std::fopen(options.output.c_str(), "wb");
+    if (!file) {
+      std::cerr << "Error when opening " << options.output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<std::uint8_t> rgb(numPixels * 3);
+  auto ok = true;
+  auto animTicks = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (long frame = 0; frame < options.frames && ok; frame++) {
+    if (anim && frame > 0 && ++animTicks >= anim->getDelay()) {
+      animTicks = 0;
+      try {
+        anim->next(*image);
+      } catch (const std::runtime_error &e) {
+        std::cerr << options.input << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (image->isTrueColor()) {
+      // deep images have no palette to cycle, the colors of HAM images are resolved again from their cycled palette
+      if (image->isHam() && image->numCycles > 0) {
+        cycler.step(*image);
+        ViewModes::resolveHam(*image);
+      }
+      std::copy_n(image->rgb.data(), rgb.size(), rgb.data());
+    } else {
+      cycler.step(*image);
+      PaletteExpand::toRgb(image->pixels().data(), numPixels, image->palette.data(), rgb.data());
+    }
+    removePadding(rgb, width, height, stride);
+    if (perFrameFiles) {
+      std::vector<char> path(options.output.size() + 32);
+      std::snprintf(path.data(), path.size(), options.output.c_str(), static_cast<int>(frame));
+      FILE *frameFile = std::fopen(path.data(), "wb");
+      if (!frameFile) {
+        std::cerr << "Error when opening " << path.data() << std::endl;
+        return EXIT_FAILURE;
+      }
+      ok = writeFrame(frameFile, options, width, height, rgb);
+      ok = std::fclose(frameFile) == 0 && ok;
+    } else {
+      ok = writeFrame(file, options, width, height, rgb);
+    }
+  }
+  if (file) {
+    ok = std::fflush(file) == 0 && ok;
+    if (file != stdout)
+      ok = std::fclose(file) == 0 && ok;
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  if (!ok) {
+    std::cerr << "Error when writing frames" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::fprintf(stderr, "%ld frames %dx%d in %.3f s (%.1f frames/s, %s expansion%s)\n", options.frames, width, height,
+               elapsed.count(), elapsed.count() > 0 ? options.frames / elapsed.count() : 0.0,
+               PaletteExpand::getKernelName(PaletteExpand::getKernel()), baked ? ", baked palettes" : "");
+  return EXIT_SUCCESS;
+}